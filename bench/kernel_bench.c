@@ -0,0 +1,258 @@
+/*** kernel benchmark ***/
+
+/* times the hot kernels of codible one at a time on generated files
+   of a few kinds: many short lines, a few giant lines, tab heavy
+   text & comment heavy C.
+   usage: kernel_bench [megabytes] [corpus ...]
+   each file is 16 MB by default, the corpora are short, giant, tabs
+   & comments. a line of tab separated values gets printed for each
+   kernel on each corpus: the corpus, the kernel, MB/s, rows/s & the
+   seconds it took. the MB are those of the file, except for draw
+   where they're the bytes of the frames
+*/
+
+#define CODIBLE_NO_MAIN
+#include "../codible.c"
+
+char *bench_words[] = {
+  "int", "return", "buffer", "row", "editor", "static", "char",
+  "while", "for", "size", "render", "highlight", "needs", "noodle",
+  "the", "of", "a", "to", "index", "cursor", "screen", "query"
+};
+
+#define BENCH_WORDS (sizeof(bench_words) / sizeof(bench_words[0]))
+// what the find kernel types, it turns up about once every 64 KB
+#define BENCH_QUERY "zebra"
+
+unsigned int bench_seed = 1;
+
+double benchSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+const char *benchWord() {
+  bench_seed = bench_seed*1103515245 + 12345;
+  if ((bench_seed >> 8) % 8192 == 0) {
+    return BENCH_QUERY;
+  }
+  return bench_words[(bench_seed >> 16) % BENCH_WORDS];
+}
+
+int benchRandom(int n) {
+  bench_seed = bench_seed*1103515245 + 12345;
+  return (bench_seed >> 16) % n;
+}
+
+void benchCorpus(FILE *fp, const char *corpus, long bytes) {
+  long written = 0;
+  bench_seed = 1;
+  while (written < bytes) {
+    struct abuf line = ABUF_INIT;
+    if (strcmp(corpus, "short") == 0) {
+      // a few words, some lines empty
+      int words = benchRandom(5);
+      for (int w=0; w<words; w++) {
+        const char *word = benchWord();
+        abAppend(&line, word, strlen(word));
+        abAppend(&line, " ", 1);
+      }
+    }
+    else if (strcmp(corpus, "giant") == 0) {
+      // a quarter of the file a line, rendered a window at a time
+      while ((long)line.len < bytes/4) {
+        const char *word = benchWord();
+        abAppend(&line, word, strlen(word));
+        abAppend(&line, benchRandom(16) ? " " : "\t", 1);
+      }
+    }
+    else if (strcmp(corpus, "tabs") == 0) {
+      // indented with tabs, & the columns lined up with them
+      int indent = benchRandom(6);
+      for (int t=0; t<indent; t++) {
+        abAppend(&line, "\t", 1);
+      }
+      int words = 1 + benchRandom(6);
+      for (int w=0; w<words; w++) {
+        const char *word = benchWord();
+        abAppend(&line, word, strlen(word));
+        abAppend(&line, "\t", 1);
+      }
+    }
+    else {
+      /* C that's mostly comments, block comments run over several
+         lines so the ones after them start inside of one
+      */
+      char text[256];
+      int kind = benchRandom(4);
+      const char *a = benchWord(), *b = benchWord();
+      if (kind == 0) {
+        snprintf(text, sizeof(text), "/* the %s of the %s, which\n"
+          "   the %s keeps for the %s\n*/", a, b, b, a);
+      }
+      else if (kind == 1) {
+        snprintf(text, sizeof(text), "int %s = %d; // %s %s", a,
+          benchRandom(1000), b, a);
+      }
+      else if (kind == 2) {
+        snprintf(text, sizeof(text), "  char *%s = \"%s /* %s */\";",
+          a, b, a);
+      }
+      else {
+        snprintf(text, sizeof(text), "// %s %s %s", a, b, a);
+      }
+      abAppend(&line, text, strlen(text));
+    }
+    abAppend(&line, "\n", 1);
+    fwrite(line.b, 1, line.len, fp);
+    written += line.len;
+    abFree(&line);
+  }
+}
+
+ptrdiff_t benchFileBytes() {
+  ptrdiff_t bytes = 0;
+  for (ptrdiff_t j=0; j<E.numrows; j++) {
+    bytes += E.row[j].size + 1;
+  }
+  return bytes;
+}
+
+void benchReport(const char *corpus, const char *kernel, double bytes,
+  double rows, double seconds) {
+  printf("%s\t%s\t%.1f\t%.0f\t%.4f\n", corpus, kernel,
+    bytes/1048576.0/seconds, rows/seconds, seconds);
+  fflush(stdout);
+}
+
+void benchKernels(const char *corpus, const char *filename,
+  const char *savename) {
+  // editorOpen(): reading, rendering & highlighting every row
+  double t = benchSeconds();
+  if (editorOpen((char *)filename) == -1) {
+    die("fopen");
+  }
+  t = benchSeconds() - t;
+  ptrdiff_t bytes = benchFileBytes();
+  benchReport(corpus, "open", bytes, E.numrows, t);
+
+  /* editorUpdateSyntax(): highlighting all of them again. the 
+     checkpoints of a long row would let it resume & stop at the 
+     first one, so they're dropped first, as a change of syntax does
+  */
+  for (ptrdiff_t j=0; j<E.numrows; j++) {
+    E.row[j].checkpointcount = 0;
+  }
+  t = benchSeconds();
+  for (ptrdiff_t j=0; j<E.numrows; j++) {
+    editorUpdateSyntax(&E.row[j]);
+  }
+  t = benchSeconds() - t;
+  benchReport(corpus, "syntax", bytes, E.numrows, t);
+
+  /* editorDrawRows() & abAppend(): a frame for every screen of the
+     file, & every so many columns along a long row
+  */
+  size_t drawn = 0;
+  ptrdiff_t screenrows = 0;
+  t = benchSeconds();
+  for (ptrdiff_t r=0; r<E.numrows; r+=E.screenrows) {
+    ptrdiff_t step = E.row[r].size/256;
+    if (step < E.screencolumns) {
+      step = E.screencolumns;
+    }
+    for (ptrdiff_t cx=0; cx==0 || cx<E.row[r].size; cx+=step) {
+      E.cy = r;
+      E.cx = editorRowCharStart(&E.row[r], cx);
+      E.rowoff = r;
+      editorScroll();
+      struct abuf ab = ABUF_INIT;
+      editorDrawRows(&ab);
+      drawn += ab.len;
+      screenrows += E.screenrows;
+      abFree(&ab);
+    }
+  }
+  t = benchSeconds() - t;
+  benchReport(corpus, "draw", drawn, screenrows, t);
+  E.cx = E.cy = E.rowoff = E.coloff = 0;
+
+  // editorRowsToString() alone, then with editorSaveFile() writing it
+  size_t len;
+  t = benchSeconds();
+  free(editorRowsToString(&len));
+  t = benchSeconds() - t;
+  benchReport(corpus, "tostring", bytes, E.numrows, t);
+  char *opened = E.filename;
+  E.filename = (char *)savename;
+  t = benchSeconds();
+  editorSaveFile();
+  t = benchSeconds() - t;
+  E.filename = opened;
+  benchReport(corpus, "save", bytes, E.numrows, t);
+
+  /* editorFindCallBack(): typing the query into the find prompt,
+     going through ten of its matches & closing the prompt. each key
+     searches the file as far as the next match
+  */
+  E.searchflags = 0;
+  char query[] = BENCH_QUERY;
+  t = benchSeconds();
+  for (size_t k=1; k<=strlen(BENCH_QUERY); k++) {
+    char typed = query[k];
+    query[k] = '\0';
+    editorFindCallBack(query, query[k-1]);
+    query[k] = typed;
+  }
+  for (int m=0; m<10; m++) {
+    editorFindCallBack(query, ARROW_DOWN);
+  }
+  editorFindCallBack(query, '\r');
+  t = benchSeconds() - t;
+  benchReport(corpus, "find", bytes, E.numrows, t);
+  editorCloseFile();
+}
+
+int main(int argc, char *argv[]) {
+  long megabytes = 16;
+  int first = 1;
+  if (argc >= 2 && isdigit((unsigned char)argv[1][0])) {
+    megabytes = atol(argv[1]);
+    first = 2;
+  }
+  const char *corpora[] = {"short", "giant", "tabs", "comments"};
+  int count = (first < argc) ? argc - first : 4;
+  codibleSelect(codibleNew());
+  E.screenrows = 40;
+  E.screencolumns = 120;
+  char filename[] = "/tmp/kernel_benchXXXXXX.c";
+  char savename[] = "/tmp/kernel_benchXXXXXX.c";
+  int fd = mkstemps(filename, 2);
+  int savefd = mkstemps(savename, 2);
+  if (fd == -1 || savefd == -1) {
+    die("mkstemps");
+  }
+  close(fd);
+  close(savefd);
+  printf("corpus\tkernel\tMB/s\trows/s\tseconds\n");
+  for (int c=0; c<count; c++) {
+    const char *corpus = (first < argc) ? argv[first + c] : corpora[c];
+    if (strcmp(corpus, "short") && strcmp(corpus, "giant") && 
+      strcmp(corpus, "tabs") && strcmp(corpus, "comments")) {
+      fprintf(stderr, "kernel_bench: no corpus %s\n", corpus);
+      continue;
+    }
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL) {
+      die("fopen");
+    }
+    benchCorpus(fp, corpus, megabytes*1048576);
+    fclose(fp);
+    benchKernels(corpus, filename, savename);
+  }
+  unlink(filename);
+  unlink(savename);
+  codibleFree(codible_editor);
+  return 0;
+}
@@ -0,0 +1,401 @@
+/*** keystroke replay benchmark ***/
+
+/* replays traces of keys against the editor of codible running on a
+   fake terminal, a pseudo terminal the benchmark types into & reads
+   the frames back from. for each trace it reports how long it took
+   from a key to the frame showing it (p50, p99 & max) & how many
+   bytes a frame wrote.
+   usage: replay_bench [lines] [trace ...]
+   lines is the size of the generated C file the traces run on,
+   200000 by default. a trace is one of the built in ones, typing,
+   paste, scroll, scroll-wrap & search, or a file of recorded keys
+   as a terminal sends them. without any, the built in ones all run
+*/
+
+#define CODIBLE_NO_MAIN
+#include "../codible.c"
+#include <sys/wait.h> // waitpid() resides in it
+
+// the bytes that end every frame, editorRefreshScreen() shows the cursor
+#define BENCH_FRAME_END "\x1b[?25h"
+// a key that got no frame after this many ms is given up on
+#define BENCH_TIMEOUT 10000
+// output that stops for this many ms means the editor is idle again
+#define BENCH_SETTLE 2
+
+/* keys sent to the editor at once, like a paste is. each of them
+   gets its own frame, measured from when they were sent
+*/
+typedef struct benchEvent {
+  size_t start, len;
+  int keys;
+} benchEvent;
+
+typedef struct benchTrace {
+  const char *name;
+  struct abuf bytes;
+  benchEvent *events;
+  int count, cap;
+} benchTrace;
+
+typedef struct benchStats {
+  double *latencies; // ms, one per key
+  int count, cap;
+  long frames; // keys' frames & the ones drawn while idle
+  size_t bytes;
+  size_t maxbytes;
+  int timeouts;
+  // how far into BENCH_FRAME_END the output is, & the frame so far
+  int matched;
+  size_t framebytes;
+} benchStats;
+
+// the master side of the fake terminal, what the keys get typed into
+int bench_master = -1;
+
+double benchSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+void benchAdd(benchTrace *trace, const char *bytes, size_t len,
+  int keys) {
+  if (trace->count == trace->cap) {
+    trace->cap = trace->cap ? trace->cap*2 : 256;
+    trace->events = editorReallocArray(trace->events, trace->cap,
+      sizeof(benchEvent));
+  }
+  benchEvent *event = &trace->events[trace->count++];
+  event->start = trace->bytes.len;
+  event->len = len;
+  event->keys = keys;
+  abAppend(&trace->bytes, bytes, len);
+}
+
+void benchKey(benchTrace *trace, const char *key) {
+  benchAdd(trace, key, strlen(key), 1);
+}
+
+void benchType(benchTrace *trace, const char *text) {
+  // a key for each byte of text, a newline is Enter
+  for (const char *p = text; *p; p++) {
+    char c = (*p == '\n') ? '\r' : *p;
+    benchAdd(trace, &c, 1, 1);
+  }
+}
+
+void benchRepeat(benchTrace *trace, const char *key, int times) {
+  for (int i=0; i<times; i++) {
+    benchKey(trace, key);
+  }
+}
+
+size_t benchKeyLength(const char *bytes, size_t len) {
+  /* the bytes a terminal sends for one key: an escape sequence, a
+     UTF-8 character or a single byte
+  */
+  unsigned char c = bytes[0];
+  size_t n = 1;
+  if (c == '\x1b' && len > 2 && (bytes[1] == '[' || bytes[1] == 'O')) {
+    n = 2;
+    while (n < len && !isalpha((unsigned char)bytes[n]) &&
+      bytes[n] != '~') {
+      n++;
+    }
+    n++;
+  }
+  else if (c >= 0xc0) {
+    while (n < len && ((unsigned char)bytes[n] & 0xc0) == 0x80) {
+      n++;
+    }
+  }
+  return (n < len) ? n : len;
+}
+
+int benchLoadTrace(benchTrace *trace, const char *path) {
+  // a recorded trace, every key of it sent on its own
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    return -1;
+  }
+  struct abuf file = ABUF_INIT;
+  char buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+    abAppend(&file, buffer, n);
+  }
+  fclose(fp);
+  trace->name = path;
+  for (size_t at=0; at<file.len; ) {
+    size_t len = benchKeyLength(&file.b[at], file.len - at);
+    benchAdd(trace, &file.b[at], len, 1);
+    at += len;
+  }
+  abFree(&file);
+  return 0;
+}
+
+int benchBuiltinTrace(benchTrace *trace, const char *name) {
+  const char *code =
+    "static int benchmarked(struct editorConfig *editor, int n) {\n"
+    "\t/* typing a function into the middle of the file */\n"
+    "\tfor (int i=0; i<n; i++) {\n"
+    "\t\tprintf(\"%d: %s\\n\", i, editor->filename);\n"
+    "\t}\n"
+    "\treturn n*42 + 0x1f;\n"
+    "}\n";
+  trace->name = name;
+  if (strcmp(name, "typing") == 0) {
+    benchType(trace, "\x07" "50%\r");
+    for (int i=0; i<8; i++) {
+      benchType(trace, code);
+    }
+  }
+  else if (strcmp(name, "paste") == 0) {
+    // a line at a time, the way a terminal hands a paste over
+    benchType(trace, "\x07" "25%\r");
+    for (int i=0; i<64; i++) {
+      const char *line = code;
+      while (*line) {
+        const char *end = strchr(line, '\n');
+        struct abuf burst = ABUF_INIT;
+        abAppend(&burst, line, end - line);
+        abAppend(&burst, "\r", 1);
+        benchAdd(trace, burst.b, burst.len, burst.len);
+        abFree(&burst);
+        line = end + 1;
+      }
+    }
+  }
+  else if (strcmp(name, "scroll") == 0 ||
+    strcmp(name, "scroll-wrap") == 0) {
+    if (name[6] == '-') {
+      benchKey(trace, "\x17");
+    }
+    benchRepeat(trace, "\x1b[6~", 300);
+    benchRepeat(trace, "\x1b[B", 500);
+    benchKey(trace, "\x1b[1;5F");
+    benchRepeat(trace, "\x1b[5~", 300);
+    benchRepeat(trace, "\x1b[A", 500);
+    benchKey(trace, "\x1b[1;5H");
+  }
+  else if (strcmp(name, "search") == 0) {
+    // typing queries into the find prompt & going through the matches
+    benchType(trace, "\x06" "editorRow");
+    benchRepeat(trace, "\x1b[C", 40);
+    benchRepeat(trace, "\x1b[D", 20);
+    benchType(trace, "\r\x06" "nowhere_to_be_found\r");
+    benchType(trace, "\x06\x12" "row->[a-z]+");
+    benchRepeat(trace, "\x1b[C", 40);
+    benchType(trace, "\x12\r");
+  }
+  else {
+    return -1;
+  }
+  return 0;
+}
+
+void benchCorpus(FILE *fp, long lines) {
+  // C with everything the highlighter looks at: comments, strings...
+  const char *names[] = {"row", "editor", "buffer", "render", "cursor",
+    "index", "screen", "query", "needs", "syntax"};
+  unsigned int seed = 1;
+  long line = 0;
+  while (line < lines) {
+    seed = seed*1103515245 + 12345;
+    const char *a = names[(seed >> 16) % 10];
+    const char *b = names[(seed >> 20) % 10];
+    fprintf(fp, "/* %s of the %s, which the %s keeps */\n"
+      "int editorRow%s%ld(erow *row, int %s) {\n"
+      "\tchar *%s = \"%s\\t%s\";\n"
+      "\tif (row->size > %u && %s != 0x%x) {\n"
+      "\t\treturn row->%s[%s] + %d; // %s\n"
+      "\t}\n"
+      "\treturn -1;\n"
+      "}\n\n", a, b, a, a, line, b, a, b, a, seed % 1000, b, seed & 0xff,
+      a, b, (int)(seed % 77), b);
+    line += 9;
+  }
+}
+
+int benchRead(benchStats *stats, int timeout) {
+  /* reading what the editor writes, waiting up to timeout ms for it.
+     returns how many frames ended in it, -1 if nothing came
+  */
+  char buffer[65536];
+  struct pollfd fd = {bench_master, POLLIN, 0};
+  if (poll(&fd, 1, timeout) <= 0) {
+    return -1;
+  }
+  ssize_t n = read(bench_master, buffer, sizeof(buffer));
+  if (n <= 0) {
+    return -1;
+  }
+  int frames = 0;
+  for (ssize_t i=0; i<n; i++) {
+    stats->framebytes++;
+    // no part of BENCH_FRAME_END starts it again but the escape
+    if (buffer[i] == BENCH_FRAME_END[stats->matched]) {
+      stats->matched++;
+    }
+    else {
+      stats->matched = (buffer[i] == '\x1b');
+    }
+    if (BENCH_FRAME_END[stats->matched] == '\0') {
+      stats->frames++;
+      stats->bytes += stats->framebytes;
+      if (stats->framebytes > stats->maxbytes) {
+        stats->maxbytes = stats->framebytes;
+      }
+      stats->framebytes = 0;
+      stats->matched = 0;
+      frames++;
+    }
+  }
+  return frames;
+}
+
+pid_t benchStartEditor(const char *filename, int rows, int columns) {
+  /* the editor as main() runs it, in a child with the slave side
+     of a new pseudo terminal for its terminal
+  */
+  bench_master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (bench_master == -1 || grantpt(bench_master) == -1 ||
+    unlockpt(bench_master) == -1) {
+    die("posix_openpt");
+  }
+  struct winsize ws = {0};
+  ws.ws_row = rows;
+  ws.ws_col = columns;
+  char *slavename = ptsname(bench_master);
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == -1) {
+    die("fork");
+  }
+  if (pid == 0) {
+    setsid();
+    int slave = open(slavename, O_RDWR);
+    if (slave == -1) {
+      die("open");
+    }
+    ioctl(slave, TIOCSWINSZ, &ws);
+    dup2(slave, STDIN_FILENO);
+    dup2(slave, STDOUT_FILENO);
+    close(slave);
+    close(bench_master);
+    enableRawMode();
+    initialEditor();
+    editorWatchResize();
+    if (editorOpen((char *)filename) == -1) {
+      die("fopen");
+    }
+    while (1) {
+      editorRefreshScreen();
+      editorProcessKeypress();
+    }
+  }
+  return pid;
+}
+
+int benchCompare(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+void benchRun(benchTrace *trace, const char *filename) {
+  pid_t pid = benchStartEditor(filename, 40, 120);
+  benchStats stats = {0};
+  // the first frame, once the file is read
+  while (benchRead(&stats, BENCH_TIMEOUT) == 0) {
+  }
+  while (benchRead(&stats, 50) != -1) {
+  }
+  stats = (benchStats){0};
+  for (int e=0; e<trace->count; e++) {
+    benchEvent *event = &trace->events[e];
+    double sent = benchSeconds();
+    if (write(bench_master, &trace->bytes.b[event->start],
+      event->len) != (ssize_t)event->len) {
+      die("write");
+    }
+    // each key of the event gets a frame
+    int frames = 0;
+    while (frames < event->keys) {
+      int ended = benchRead(&stats, BENCH_TIMEOUT);
+      if (ended == -1) {
+        stats.timeouts += event->keys - frames;
+        break;
+      }
+      double latency = (benchSeconds() - sent)*1e3;
+      for (int k=0; k<ended && frames<event->keys; k++, frames++) {
+        if (stats.count == stats.cap) {
+          stats.cap = stats.cap ? stats.cap*2 : 1024;
+          stats.latencies = editorReallocArray(stats.latencies, 
+            stats.cap, sizeof(double));
+        }
+        stats.latencies[stats.count++] = latency;
+      }
+    }
+    // what's drawn while the editor is idle counts as frames too
+    while (benchRead(&stats, BENCH_SETTLE) != -1) {
+    }
+  }
+  kill(pid, SIGKILL);
+  waitpid(pid, NULL, 0);
+  close(bench_master);
+
+  qsort(stats.latencies, stats.count, sizeof(double), benchCompare);
+  int n = stats.count;
+  double p50 = n ? stats.latencies[n/2] : 0;
+  double p99 = n ? stats.latencies[(n*99)/100 < n ? (n*99)/100 : n-1] : 0;
+  double max = n ? stats.latencies[n-1] : 0;
+  printf("%-14s %6d %9.3f %9.3f %9.3f %10.0f %10zu %7ld", trace->name,
+    n, p50, p99, max, stats.frames ? (double)stats.bytes/stats.frames :
+    0.0, stats.maxbytes, stats.frames);
+  if (stats.timeouts) {
+    printf("  (%d keys got no frame)", stats.timeouts);
+  }
+  printf("\n");
+  fflush(stdout);
+  free(stats.latencies);
+}
+
+int main(int argc, char *argv[]) {
+  long lines = 200000;
+  int first = 1;
+  if (argc >= 2 && isdigit((unsigned char)argv[1][0])) {
+    lines = atol(argv[1]);
+    first = 2;
+  }
+  char filename[] = "/tmp/replay_benchXXXXXX.c";
+  int fd = mkstemps(filename, 2);
+  FILE *fp = (fd == -1) ? NULL : fdopen(fd, "w");
+  if (fp == NULL) {
+    die("mkstemps");
+  }
+  benchCorpus(fp, lines);
+  fclose(fp);
+
+  const char *builtin[] = {"typing", "paste", "scroll", "scroll-wrap",
+    "search"};
+  int count = (first < argc) ? argc - first : 5;
+  printf("%ld lines, 40x120 terminal, latencies in ms\n", lines);
+  printf("%-14s %6s %9s %9s %9s %10s %10s %7s\n", "trace", "keys",
+    "p50", "p99", "max", "bytes/frm", "max bytes", "frames");
+  for (int t=0; t<count; t++) {
+    const char *name = (first < argc) ? argv[first + t] : builtin[t];
+    benchTrace trace = {0};
+    if (benchBuiltinTrace(&trace, name) == -1 &&
+      benchLoadTrace(&trace, name) == -1) {
+      fprintf(stderr, "replay_bench: no trace %s\n", name);
+      continue;
+    }
+    benchRun(&trace, filename);
+    abFree(&trace.bytes);
+    free(trace.events);
+  }
+  unlink(filename);
+  return 0;
+}
@@ -0,0 +1,150 @@
+/*** search benchmark ***/
+
+/* compares the search engine of codible against the strstr() loop
+   the find prompt used before it, on a generated file of text rows.
+   usage: search_bench [megabytes] [query]
+   it defaults to a 1024 MB file & the query "needle"
+*/
+
+#include "../codible_internal.h"
+
+char *bench_words[] = {
+  "int", "return", "buffer", "row", "editor", "static", "char",
+  "while", "for", "size", "render", "highlight", "needs", "noodle",
+  "the", "of", "a", "to", "index", "cursor", "screen", "query"
+};
+
+#define BENCH_WORDS (sizeof(bench_words) / sizeof(bench_words[0]))
+
+double benchSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+int main(int argc, char *argv[]) {
+  long megabytes = (argc >= 2) ? atol(argv[1]) : 1024;
+  char *query = (argc >= 3) ? argv[2] : "needle";
+  long total = megabytes*1024*1024;
+  /* the rows live back to back in one buffer, each one ending with
+     a '\0' like the chars of an erow, so strstr() can run on them
+  */
+  char *text = malloc(total + 128);
+  long *starts = malloc(sizeof(long)*(total/16 + 1));
+  int *sizes = malloc(sizeof(int)*(total/16 + 1));
+  if (text == NULL || starts == NULL || sizes == NULL) {
+    fprintf(stderr, "search_bench: out of memory\n");
+    return 1;
+  }
+  long numrows = 0, pos = 0;
+  unsigned int seed = 1;
+  while (pos < total) {
+    starts[numrows] = pos;
+    int width = 20 + (seed >> 16) % 80;
+    while (pos - starts[numrows] < width) {
+      seed = seed*1103515245 + 12345;
+      char *word = bench_words[(seed >> 16) % BENCH_WORDS];
+      // the query itself turns up about once every 64 KB
+      if ((seed >> 8) % 8192 == 0) {
+        word = query;
+      }
+      int len = strlen(word);
+      memcpy(&text[pos], word, len);
+      pos += len;
+      text[pos++] = ' ';
+    }
+    sizes[numrows] = pos - starts[numrows];
+    text[pos++] = '\0';
+    numrows++;
+  }
+  printf("%ld rows, %.1f MB, query \"%s\"\n", numrows, pos/1048576.0,
+    query);
+
+  // the old find prompt: strstr() on each row, first match only
+  double t = benchSeconds();
+  long rows = 0;
+  for (long r=0; r<numrows; r++) {
+    if (strstr(&text[starts[r]], query)) {
+      rows++;
+    }
+  }
+  t = benchSeconds() - t;
+  printf("%-28s %10ld rows   %8.1f ms %8.1f MB/s\n", "strstr per row",
+    rows, t*1e3, pos/1048576.0/t);
+
+  /* regexes: the query followed by word characters, which the DFA
+     only reads where the literal search found the query, & one 
+     without a literal prefix, which the DFA reads all of
+  */
+  char prefixed[256], unprefixed[256];
+  snprintf(prefixed, sizeof(prefixed), "%s\\w*", query);
+  snprintf(unprefixed, sizeof(unprefixed), "[%c%c]%s", 
+    tolower((unsigned char)query[0]), toupper((unsigned char)query[0]), 
+    query + 1);
+  int modes[] = {0, SEARCH_IGNORE_CASE, SEARCH_WHOLE_WORD,
+    SEARCH_IGNORE_CASE | SEARCH_WHOLE_WORD, SEARCH_REGEX, SEARCH_REGEX};
+  char *patterns[] = {query, query, query, query, prefixed, unprefixed};
+  char *names[] = {"engine", "engine, ignore case", "engine, whole word",
+    "engine, both", "regex, literal prefix", "regex, no prefix"};
+  for (int m=0; m<6; m++) {
+    editorSearch search = {0};
+    editorSearchCompile(&search, patterns[m], modes[m]);
+    t = benchSeconds();
+    long matches = 0;
+    // every match of every row, not just the first one
+    for (long r=0; r<numrows; r++) {
+      char *chars = &text[starts[r]];
+      int at = editorSearchForward(&search, chars, sizes[r], 0);
+      while (at != -1) {
+        matches++;
+        at = editorSearchForward(&search, chars, sizes[r], at + 1);
+      }
+    }
+    t = benchSeconds() - t;
+    printf("%-28s %10ld matches %8.1f ms %8.1f MB/s\n", names[m],
+      matches, t*1e3, pos/1048576.0/t);
+    editorSearchFree(&search);
+  }
+
+  /* typing the query one character at a time. the old prompt
+     started again from the first row on every keystroke, the find
+     prompt now goes on from the match it is on
+  */
+  int qlen = strlen(query);
+  char *prefix = malloc(qlen + 1);
+  t = benchSeconds();
+  for (int k=1; k<=qlen; k++) {
+    memcpy(prefix, query, k);
+    prefix[k] = '\0';
+    for (long r=0; r<numrows; r++) {
+      if (strstr(&text[starts[r]], prefix)) {
+        break;
+      }
+    }
+  }
+  double old = benchSeconds() - t;
+  editorSearch search = {0};
+  long r = 0;
+  int at = 0;
+  t = benchSeconds();
+  for (int k=1; k<=qlen; k++) {
+    memcpy(prefix, query, k);
+    prefix[k] = '\0';
+    editorSearchCompile(&search, prefix, 0);
+    for (; r<numrows; r++, at=0) {
+      at = editorSearchForward(&search, &text[starts[r]], sizes[r], at);
+      if (at != -1) {
+        break;
+      }
+    }
+  }
+  t = benchSeconds() - t;
+  printf("typing the query: strstr %.3f ms, engine %.3f ms\n",
+    old*1e3, t*1e3);
+  editorSearchFree(&search);
+  free(prefix);
+  free(text);
+  free(starts);
+  free(sizes);
+  return 0;
+}
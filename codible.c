@@ -1,45 +1,24 @@
 /*** includes ***/
 
-#define _DEFAULT_SOURCE
-#define _BSD_SOURCE
-#define _GNU_SOURCE
-
-#include <ctype.h> // iscntrl() resides in it
-#include <stdio.h> 
-/* printf(), perror(), sscanf(), snprintf(), FILE,
-   fopen(), getline(), vsnprintf() reside in it
-*/
-#include <stdlib.h> 
-// atexit(), exit(), realloc(), free(), malloc() reside in it 
+#include "codible_internal.h"
 #include <termios.h> 
 /* struct termios, tcgetattr(), tcsetattr(), ECHO, TCSAFLUSH, 
    ICANON, ISIG, IXON. IEXTEN, ICRNL, OPOST, BRKINT, INPCK, 
    ISTRIP, CS8, VMIN, VTIME reside in it
 */
-#include <unistd.h> 
-/* read(), STDIN_FILENO, write(), STDOUT_FILENO
-   ftruncate(), close() reside in it
-*/
-#include <errno.h> // errno, EAGAIN reside in it
 #include <sys/ioctl.h> 
 // ioctl(), TIOCGWINSZ, struct winsize reside in it.
-#include <string.h> 
-/* memcpy(), strlen(), strdup(), memmove(), strerror(), 
-   strstr(), memset(), strchr(), strrchr(), strcmp(), 
-   strncmp() reside in it
-*/
-#include <sys/types.h> // ssize_t resides in it
-#include <time.h> // time_t, time() reside in it
-#include <stdarg.h> // va_list, va_start(), va_end() reside in it
-#include <fcntl.h> // open(), O_RDWR, O_CREAT reside in it 
 
 /*** defines ***/
 
-#define CODIBLE_VERSION "0.0.1"
 #define CTRL_KEY(k) ((k) & 0x1f)
-#define CODIBLE_TAB_STOP 8
 // press Ctrl-Q 3 more times to quit the editor without saving
 #define CODIBLE_QUIT_TIMES 3 
+/* the bytes of renders, highlights & wrap points the buffers that 
+   aren't shown keep between them, past it the ones shown longest ago
+   drop theirs
+*/
+#define CODIBLE_HIDDEN_MEMORY (64 << 20)
 
 // mapping WASD keys with the arrow constants
 enum editorKey {
@@ -53,128 +32,113 @@ enum editorKey {
   HOME_KEY, // 1529
   END_KEY, // 1530
   PAGE_UP, // 1531
-  PAGE_DOWN // 1532
+  PAGE_DOWN, // 1532
+  FILE_START, // 1533, Ctrl-Home
+  FILE_END // 1534, Ctrl-End
 };
 
-enum editorHighlight {
-  HL_NORMAL = 0,
-  HL_COMMENT,
-  HL_MLCOMMENT,
-  HL_KEYWORD1,
-  HL_KEYWORD2,
-  HL_STRING,
-  HL_NUMBER,
-  HL_MATCH
+// an open file, an editor of its own
+typedef struct editorBuffer {
+  struct editorConfig *editor;
+  long shown; // when it was last switched to
+} editorBuffer;
+
+// how a split lays out its two panes
+enum editorSplit {
+  SPLIT_NONE = 0, // a pane of its own
+  SPLIT_ROWS, // one above the other
+  SPLIT_COLUMNS // side by side
 };
 
-#define HL_HIGHLIGHT_NUMBERS (1<<0)
-#define HL_HIGHLIGHT_STRINGS (1<<1)
+/* a pane shows a view of a buffer, or is split in two panes. panes 
+   of the same buffer share its rows & their highlighting, each only
+   has its own place in the file. the focused pane's is in the editor
+   itself, where the cursor & scrolling code works on it, the others
+   keep theirs parked here
+*/
+typedef struct editorPane {
+  int split;
+  struct editorPane *first, *second, *parent;
+  struct editorConfig *editor;
+  ptrdiff_t cx, cy, rowoff, coloff, wrapoff;
+  // where it is on the terminal, its status bar included
+  int top, left, rows, columns;
+  // what each of its lines showed the last frame
+  struct abuf *shown;
+  int shownrows;
+} editorPane;
 
 /*** data ***/
 
-struct editorSyntax {
-  char *filetype;
-  char **filematch;
-  char **keywords;
-  char *singleline_comment_start;
-  char *multiline_comment_start;
-  char *multiline_comment_end;
-  int flags;
-};
-
-// editor row
-typedef struct erow {
-  // index of the row in the file at the time it is inserted
-  int index;
-  // the size of rendering characters
-  int size;
-  int rsize;
-  // store a line of text as a pointer
-  char *chars;
-  // for rendering the non-printable characters;
-  char *render;
-  // highlighted array
-  unsigned char *highlight;
-  int hl_open_comment;
-
-} erow;
-
-struct editorConfig {
-  int cx, cy;
-  int rx;
-  int rowoff;
-  int coloff;
-  int screenrows;
-  int screencolumns;
-  int numrows; // number of rows to be displayed
-  erow *row;  // making erow arrays for taking multiple lines
-  int dirty;  // identify if the buffer is changed
-  char *filename;
-  char statusmessage[80];
-  time_t statusmessage_time;
-  struct editorSyntax *syntax;
-  struct termios original;
-};
-
-struct editorConfig E;
+// the settings of the terminal before raw mode, put back at exit
+struct termios original;
 
-/*** filetypes ***/
+// counts the SIGWINCH signals, it's all a signal handler may touch
+volatile sig_atomic_t window_resizes = 0;
 
-char *C_HL_extensions[] = {".c", ".h", ".cpp", NULL};
-/* C specific keywords are Null terminated & 
-   common keywords are pipe terminated
+/* the editor of the file under the scratch buffer the memory report
+   is shown in, NULL while it isn't shown
 */
-char *C_HL_keywords[] = {
-  "switch", "if", "while", "for", "break", "continue", "return",
-  "else", "struct", "union", "typedef", "static", "enum", "class",
-  "case", 
-
-  "int|", "long|", "double|", "float|", "char|", "unsigned|",
-  "signed|", "void|", NULL
-};
-// highlight database;
-struct editorSyntax HLDB[] = {
-  {
-    "c",
-    C_HL_extensions,
-    C_HL_keywords,
-    "//", "/*", "*/",
-    HL_HIGHLIGHT_NUMBERS | HL_HIGHLIGHT_STRINGS
-  },
-};
-
-#define HLDB_ENTRIES (sizeof(HLDB) / sizeof(HLDB[0]))
+struct editorConfig *scratch_under = NULL;
+
+// the buffers in the order they were opened
+editorBuffer *buffers = NULL;
+int buffercount = 0;
+long buffershown = 0; // counts the switches
+
+// the panes the terminal is split into, above the message bar
+editorPane *pane_root = NULL;
+editorPane *pane_focus = NULL;
+// the pane being drawn, its lines go to their places on the terminal
+editorPane *pane_drawn = NULL;
+int screen_rows = 0, screen_columns = 0;
+/* the terminal has to be cleared & every line drawn again, after a
+   resize or a change of the panes
+*/
+int screen_stale = 1;
+// what the message bar showed the last frame
+struct abuf message_shown = ABUF_INIT;
+// the terminal line written last in the frame, -1 before any
+int screen_written = -1;
 
 /*** prototypes ***/
 
-void editorSetStatusMessage(const char *fmt, ...);
 void editorRefreshScreen();
+void editorCheckResize();
+void editorPanesLayout();
+void editorScroll();
 char *editorPrompt(char *prompt, void (*callback)(char *, int));
+char *editorPromptFor(char *prompt, void (*callback)(char *, int), 
+  int empty);
+void editorMemoryView();
+struct editorConfig *editorBufferNew();
+int editorBufferAdd(struct editorConfig *editor);
+int editorBufferFile(char *filename);
+void editorBufferShow(int k);
 
 /*** terminal ***/
 
-void die(const char *s) {
+void editorClearScreen() {
+  // what a fatal error leaves behind it is all that's on the screen
   write(STDOUT_FILENO, "\x1b[2J", 4);
   write(STDOUT_FILENO, "\x1b[H", 3);
-  perror(s); // returns error messages from errno global variable
-  exit(1);
 }
 
 void disableRawMode() {
   // error checking for setting up
-  if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &E.original) == -1) {
+  if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &original) == -1) {
     die("tcsetattr");
   }
 }
 
 void enableRawMode() {
   // error checking for loading up
-  if (tcgetattr(STDIN_FILENO, &E.original) == -1) {
+  if (tcgetattr(STDIN_FILENO, &original) == -1) {
     die("tcgetattr");
   }
   atexit(disableRawMode); 
 
-  struct termios raw = E.original;
+  struct termios raw = original;
   raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON); 
   /* IXON used to ignore XOFF and XON & ICRNL used to handle 
      Carriage Return (CR) and New Line (NL), 
@@ -198,32 +162,61 @@ void enableRawMode() {
   }
 }
 
+int editorReadByte(char *c) {
+  // a read() that isn't cut short by a resize signal
+  int nread;
+  while ((nread = read(STDIN_FILENO, c, 1)) == -1 && errno == EINTR) {
+  }
+  return nread;
+}
+
 int editorReadKey() {
   // read the keypress
   int nread;
-  char c;
+  /* unsigned, so the bytes of a UTF-8 character come out as 
+     128 .. 255 instead of negative numbers
+  */
+  unsigned char c;
   while ((nread = read(STDIN_FILENO, &c, 1)) != 1) {
-    if (nread == -1 && errno != EAGAIN) {
+    // EINTR only means a signal came in while waiting
+    if (nread == -1 && errno != EAGAIN && errno != EINTR) {
       die("read");
     }
+    editorCheckResize();
+    editorIdle();
   }
   if (c=='\x1b') {
     char seq[3];
     /* checking the escape sequence for determining "Escape" or
        "Arrow" keys.
     */
-    if (read(STDIN_FILENO, &seq[0], 1) != 1) {
+    if (editorReadByte(&seq[0]) != 1) {
       return '\x1b';
     }
-    if (read(STDIN_FILENO, &seq[1], 1) != 1) {
+    if (editorReadByte(&seq[1]) != 1) {
       return '\x1b';
     }
     if (seq[0] == '[') {
       if (seq[1]>='0' && seq[1]<='9') {
 	// checking that after '[', is it a digit or not
-	if (read(STDIN_FILENO, &seq[2], 1) != 1) {
+	if (editorReadByte(&seq[2]) != 1) {
 	  return '\x1b';
 	}
+	if (seq[2] == ';') {
+	  /* a key with a modifier, "\x1b[1;5H" is Ctrl-Home & 
+	     "\x1b[1;5F" Ctrl-End
+	  */
+	  char mod[2];
+	  if (editorReadByte(&mod[0]) != 1 || editorReadByte(&mod[1]) != 1) {
+	    return '\x1b';
+	  }
+	  if (mod[0] == '5' && mod[1] == 'H') {
+	    return FILE_START;
+	  }
+	  if (mod[0] == '5' && mod[1] == 'F') {
+	    return FILE_END;
+	  }
+	}
 	if (seq[2] == '~') {
 	  /* digit 5 for page up, 6 for page down
 	     digit 1 or 7 for Home, 4 or 8 for End
@@ -319,469 +312,366 @@ int getWindowSize(int *rows, int *columns) {
   }
 }
 
-/*** syntax highlighting ***/
-
-int is_separator (int c) {
-  /* if the string doesn't contain the characters
-     provided in the strchr(), the function will
-     return NULL
-  */
-  return (isspace(c) || c=='\0' || 
-    strchr(",.()+-/*=~%<>[];", c) != NULL);
+void editorHandleSigwinch(int signum) {
+  (void)signum;
+  window_resizes++;
 }
 
-void editorUpdateSyntax(erow *row) {
-  row->highlight = realloc(row->highlight, row->rsize);
-  memset(row->highlight, HL_NORMAL, row->rsize);
-  if (E.syntax == NULL) {
-    return;
-  }
-  char **keywords = E.syntax->keywords;
-  char *scs = E.syntax->singleline_comment_start;
-  char *mcs = E.syntax->multiline_comment_start;
-  char *mce = E.syntax->multiline_comment_end;
-  int scs_len = scs ? strlen(scs) : 0;
-  int mcs_len = mcs ? strlen(mcs) : 0;
-  int mce_len = mce ? strlen(mce) : 0;
-  // considering the starting of a line as a separator
-  int i = 0, prev_separator = 1, in_string = 0;
-  int in_comment = (row->index > 0 && E.row[row->index - 1].hl_open_comment);
-  while (i < row->rsize) {
-    char c = row->render[i];
-    unsigned char prev_highlight = (i>0) ? row->highlight[i-1] : 
-      HL_NORMAL;
-    if (scs_len && !in_string && !in_comment) {
-      /* using strncmp() to check if this character
-         is the start of a single line comment
-      */
-      if (!strncmp(&row->render[i], scs, scs_len)) {
-        memset(&row->highlight[i], HL_COMMENT, row->rsize-i);
-        break;
-      }
-    }
-    if (mcs_len && mce_len && !in_string) {
-      if (in_comment) {
-        row->highlight[i] = HL_MLCOMMENT;
-        if (!strncmp(&row->render[i], mce, mce_len)) {
-          // checking if we are at the end of a multi line comment
-          memset(&row->highlight[i], HL_MLCOMMENT, mce_len);
-          i = i+mce_len;
-          in_comment = 0;
-          prev_separator = 1;
-          continue;
-        }
-        else {
-          i++;
-          continue;
-        }
-      }
-      else if (!strncmp(&row->render[i], mcs, mcs_len)) {
-        // checking if we are at the beginning of a multi line comment
-        memset(&row->highlight[i], HL_MLCOMMENT, mcs_len);
-        i = i+mcs_len;
-        in_comment = 1; // setting in_comment to TRUE
-        continue;
-      }
-    }
-    if (E.syntax->flags && HL_HIGHLIGHT_STRINGS) {
-      if (in_string) {
-        row->highlight[i] = HL_STRING;
-        if (c == '\\' && i+1 < row->rsize) {
-          row->highlight[i+1] = HL_STRING;
-          i = i + 2;
-          continue;
-        }
-        if (c == in_string) {
-          in_string = 0;
-        }
-        i++;
-        prev_separator = 1;
-        continue;
-      }
-      else {
-        if (c=='"' || c=='\'') {
-          in_string = c;
-          row->highlight[i] = HL_STRING;
-          i++;
-          continue;
-        }
-      }
-    }
-    if (E.syntax->flags && HL_HIGHLIGHT_NUMBERS) {
-      if ((isdigit(c) && 
-            (prev_separator||prev_highlight==HL_NUMBER)) 
-            || (c == '.' && prev_highlight == HL_NUMBER)) {
-        row->highlight[i] = HL_NUMBER;
-        i++;
-        prev_separator = 0;
-        continue;
-      }
-    }
-    if (prev_separator) {
-      int j;
-      for (j=0; keywords[j]; j++) {
-        int klen = strlen(keywords[j]);
-        int kw2 = keywords[j][klen-1] == '|';
-        if (kw2) {
-          klen--;
-        }
-        if (!strncmp(&row->render[i], keywords[j], klen) && 
-          is_separator(row->render[i+klen])) {
-            memset(&row->highlight[i], kw2 ? HL_KEYWORD2 :
-              HL_KEYWORD1, klen);
-            i += klen;
-            break;
-          }
-      }
-      if (keywords[j] != NULL) {
-        prev_separator = 0;
-        continue;
-      }
-    }
-    prev_separator = is_separator(c);
-    i++;
-  }
-  int changed = (row->hl_open_comment != in_comment);
-  // Setting whether the row ended as an unclosed multi line comment or not
-  row->hl_open_comment = in_comment;
-  if (changed && row->index + 1 < E.numrows) {
-    editorUpdateSyntax(&E.row[row->index + 1]);
+void editorWatchResize() {
+  /* no SA_RESTART, so a resize interrupts the read() waiting for a
+     key & gets noticed right away
+  */
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = editorHandleSigwinch;
+  sigemptyset(&sa.sa_mask);
+  if (sigaction(SIGWINCH, &sa, NULL) == -1) {
+    die("sigaction");
   }
 }
 
-int editorSyntaxToColor(int highlight) {
-  switch (highlight) {
-    case HL_COMMENT:
-    case HL_MLCOMMENT:
-      // single line comments & multi line comments coloring with cyan
-      return 36;
-    case HL_KEYWORD1:
-      // keywords coloring with yellow
-      return 33;
-    case HL_KEYWORD2:
-      // keywords coloring with green
-      return 32;
-    case HL_STRING:
-      // strings coloring with magenta
-      return 35;
-    case HL_NUMBER:
-    // digits coloring with red
-      return 31;
-    case HL_MATCH:
-    // matched string coloring with blue
-      return 34;
-    default:
-      return 37;
+void editorResize() {
+  /* taking the new size of the terminal. only the soft wrap points
+     depend on the width, each row notices the change by itself 
+     when it gets drawn, so nothing has to be invalidated here
+  */
+  int rows, columns;
+  if (getWindowSize(&rows, &columns) == -1) {
+    return;
   }
+  screen_rows = (rows > 3) ? rows : 3;
+  screen_columns = (columns > 0) ? columns : 1;
+  editorPanesLayout();
+  // the scroll offsets follow the cursor on the next refresh
+  editorRefreshScreen();
 }
 
-void editorSelectSyntaxHighlight() {
-  E.syntax = NULL;
-  if (E.filename == NULL) {
-    return;
-  }
-  /* strrchr() returns a pointer to the last occurance of
-     a character in a string
+void editorCheckResize() {
+  /* called while waiting for a key. dragging the edge of a window 
+     sends a storm of signals, redrawing for each of them would 
+     only pile up frames the terminal is too slow to show
   */
-  char *ext = strrchr(E.filename, '.');
-  for(unsigned int j=0; j<HLDB_ENTRIES; j++) {
-    struct editorSyntax *s = &HLDB[j];
-    unsigned int i = 0;
-    while(s->filematch[i]) {
-      int is_ext = (s->filematch[i][0] == '.');
-      if ((is_ext && ext && !strcmp(ext, s->filematch[i])) || 
-            (!is_ext && strstr(E.filename, s->filematch[i]))) {
-        E.syntax = s;
-        for (int filerow = 0; filerow < E.numrows; filerow++) {
-          editorUpdateSyntax(&E.row[filerow]);
-        }
-        return;
-      }
-      i++;
+  static sig_atomic_t seen = 0;
+  static long changed = 0, drawn = 0;
+  static int pending = 0;
+  long now = editorMilliseconds();
+  if (window_resizes != seen) {
+    seen = window_resizes;
+    changed = now;
+    if (!pending) {
+      pending = 1;
+      drawn = now;
     }
   }
+  if (pending && (now - changed >= CODIBLE_RESIZE_QUIET || 
+    now - drawn >= CODIBLE_RESIZE_INTERVAL)) {
+    pending = (now - changed < CODIBLE_RESIZE_QUIET);
+    drawn = now;
+    editorResize();
+  }
 }
 
-/*** row operations ***/
+/*** find ***/
 
-int editorRowCxToRx (erow *row, int cx) {
-  int rx = 0;
-  for (int j=0; j<cx; j++) {
-    if (row->chars[j] == '\t') {
-      rx = rx + (CODIBLE_TAB_STOP - 1) - (rx % CODIBLE_TAB_STOP);
-      /* (rx % CODIBLE_TAB_STOP) = how many columns to the right
-         of the last tab stop
-         (CODIBLE_TAB_STOP - 1) = how many columns to the left
-         of the next tab stop
-         Added these with rx to get to the next tab stop
-      */
-    }
-    rx++; // gets on the next tab stop
-  } 
-  return rx;
+char *editorFindPrompt(const char *error) {
+  /* the search prompt names the modes that are on, & why the regex
+     is invalid if it is. it's rebuilt in place when they change, 
+     editorPrompt() picks that up on its next redraw
+  */
+  static char prompt[80];
+  snprintf(prompt, sizeof(prompt), "Search%s%s%s: %%s (%s)",
+    (E.searchflags & SEARCH_IGNORE_CASE) ? " [Aa]" : "",
+    (E.searchflags & SEARCH_WHOLE_WORD) ? " [word]" : "",
+    (E.searchflags & SEARCH_REGEX) ? " [regex]" : "",
+    error ? error : "ESC/Arrows/Enter, ^C case ^W word ^R regex");
+  return prompt;
 }
 
-int editorRowRxToCx(erow *row, int rx) {
-  int current_rx=0,cx;
-  for (cx = 0; cx < row->size; cx++) {
-    if (row->chars[cx] == '\t') {
-      current_rx += (CODIBLE_TAB_STOP-1)-(current_rx%CODIBLE_TAB_STOP);
-    }
-    current_rx++;
-    if (current_rx > rx) {
-      return cx;
-    }
+void editorFindCallBack(char *query, int key) {
+  /* last match is the index in the row that have
+     searched previous query
+  */
+  static ptrdiff_t last_match = -1;
+  // direction 1 means forward search, 
+  // diredtion 2 means backward search
+  // direction 0 keeps the current match if it still matches
+  static int direction = 1;
+  // where in the row the last match starts & what it matched
+  static ptrdiff_t last_cx = 0;
+  static char *last_query = NULL;
+  static editorSearch search = {0};
+  /* every match of the query when there aren't too many of them, 
+     the arrows then move between them without searching again
+  */
+  static editorSearchResults results = {0};
+  static int results_complete = 0;
+  /* a key that comes in during a search cuts it short, Enter lets 
+     that search finish first so the cursor still gets to the match
+  */
+  static int cut_short = 0;
+  static int finishing = 0;
+  if (key == '\r' && cut_short && !finishing) {
+    finishing = 1;
+    editorFindCallBack(query, key);
+    finishing = 0;
   }
-  return cx;
-}
-
-void editorUpdateRow(erow *row) {
-  int tabs = 0;
-  for (int j=0; j<row->size; j++) {
-    // counting tabs found in chars of the row
-    if (row->chars[j] == '\t') {
-      tabs++;
+  /* stopping incremental search if the user pressed 
+     ENTER or ESC key, unless the search before it is finishing
+  */
+  if (!finishing && (key == '\r' || key == '\x1b')) {
+    /* resetting last_match and direction to get ready
+       for next search operation
+    */
+    last_match = -1;
+    direction = 1;
+    free(last_query);
+    last_query = NULL;
+    editorSearchFree(&search);
+    editorResultsFree(&results);
+    results_complete = 0;
+    cut_short = 0;
+    editorFindStop();
+    return;
+  }
+  else if (key == ARROW_RIGHT || key == ARROW_DOWN) {
+    direction = 1;
+  }
+  else if (key == ARROW_LEFT || key == ARROW_UP) {
+    direction = -1;
+  }
+  else if (key == CTRL_KEY('c') || key == CTRL_KEY('w') || 
+    key == CTRL_KEY('r')) {
+    E.searchflags ^= (key == CTRL_KEY('c')) ? SEARCH_IGNORE_CASE : 
+      (key == CTRL_KEY('w')) ? SEARCH_WHOLE_WORD : SEARCH_REGEX;
+    // staying on the current match if it still is one
+    direction = 0;
+  }
+  else if (!finishing) {
+    /* a string that only got longer can't match before the current
+       match, so the search goes on from there instead of the top.
+       a longer regex can, "a" becoming "a|b" say. a search that's 
+       finishing goes on with what the key before it set up
+    */
+    if (last_match == -1 || last_query == NULL || 
+      (E.searchflags & SEARCH_REGEX) || 
+      strlen(query) <= strlen(last_query) || 
+      strncmp(query, last_query, strlen(last_query)) != 0) {
+      last_match = -1;
     }
+    direction = 0;
   }
-  free(row->render);
-  /* the maximum number of characters needed
-     for a tab is 8
-  */
-  row->render = malloc(row->size + tabs*(CODIBLE_TAB_STOP-1) + 1);
-  int index = 0;
-  for (int j=0; j<row->size; j++) {
-    /* if a tab is found, replace it with a space
-       until the tab stop location
+  if (last_match == -1) {
+    direction = 1;
+  }
+  // preparing the query only when it or the modes changed
+  if (search.pattern == NULL || search.flags != E.searchflags || 
+    last_query == NULL || strcmp(query, last_query) != 0) {
+    /* a string that got longer only matches on the rows the shorter
+       one did, so just those rows get another look. anything else 
+       searches the whole file again: a longer regex can match 
+       elsewhere, and so can a longer whole word
     */
-    if (row->chars[j] == '\t') {
-      row->render[index++] = ' ';
-      // tab stop location can be divided by 8
-      while (index%CODIBLE_TAB_STOP != 0) {
-        row->render[index++] = ' ';
-      }
+    int narrow = results_complete && search.pattern != NULL && 
+      search.flags == E.searchflags && 
+      !(E.searchflags & (SEARCH_REGEX | SEARCH_WHOLE_WORD)) && 
+      strlen(query) > strlen(last_query) && 
+      strncmp(query, last_query, strlen(last_query)) == 0;
+    editorSearchCompile(&search, query, E.searchflags);
+    free(last_query);
+    last_query = strdup(query);
+    // showing the modes in the prompt, or what's wrong with the regex
+    editorSetStatusMessage(editorFindPrompt(search.error), query);
+    if (narrow) {
+      editorResultsNarrow(&search, &results);
     }
     else {
-      row->render[index++] = row->chars[j];
+      results_complete = editorSearchCollect(&search, &results);
+      if (results_complete == -1) {
+        // a key came in meanwhile, its own search takes over
+        results_complete = 0;
+        cut_short = 1;
+        editorFindStart(&search, &results, 0);
+        return;
+      }
+    }
+    editorFindStart(&search, &results, results_complete);
+  }
+  ptrdiff_t filerow = 0, cx = 0;
+  if (last_match != -1) {
+    filerow = last_match;
+    cx = last_cx;
+    if (direction > 0) {
+      erow *row = &E.row[last_match];
+      cx = editorSearchNext(&search, row->chars, row->size, cx);
     }
   }
-  row->render[index] = '\0';
-  row->rsize = index;
-  editorUpdateSyntax(row);
-}
-
-void editorInsertRow (int at, char *s, size_t len) {
-  if (at<0 || at>E.numrows) {
-    // validating the index
+  ptrdiff_t current, at;
+  int found;
+  editorSetStatusMessage(editorFindPrompt(search.error), query);
+  if (results_complete) {
+    found = editorResultsNearest(&results, filerow, cx, 
+      direction ? direction : 1, &current, &at);
+  }
+  else {
+    found = editorSearchParallel(&search, filerow, cx, 
+      direction ? direction : 1, &current, &at);
+  }
+  if (found == -1) {
+    // a key came in meanwhile, its own search takes over
+    cut_short = 1;
     return;
   }
-  E.row = realloc(E.row, sizeof(erow)*(E.numrows + 1));
-  memmove(&E.row[at+1], &E.row[at], sizeof(erow)*(E.numrows-at));
-  for (int j=at+1; j<=E.numrows; j++) {
-    /* updating index of the row because of the insertion
-       of the new row
+  cut_short = 0;
+  E.find.matchrow = found ? current : -1;
+  E.find.position = 0;
+  if (found) {
+    E.find.matchcx = at;
+    last_match = current;
+    last_cx = at;
+    E.cy = current;
+    E.cx = at;
+    /* the matching line will always be on top by setting 
+       the rowoff very bottom of the file
     */
-    E.row[j].index++;
-  }
-  E.row[at].index = at;
-  E.row[at].size = len;
-  E.row[at].chars = malloc(len + 1);
-  memcpy(E.row[at].chars, s, len);
-  E.row[at].chars[len] = '\0';
-  /* Initializing the rendering size is 0 
-     and the rendering string is NULL
+    E.rowoff = E.numrows;
+  }
+}
+
+char *editorFindQuery() {
+  /* the find prompt, returning what was searched for or NULL if it
+     got cancelled
   */
-  E.row[at].rsize = 0;
-  E.row[at].render = NULL;
-  E.row[at].highlight = NULL;
-  E.row[at].hl_open_comment = 0;
-  editorUpdateRow(&E.row[at]);
-  E.numrows++;
-  E.dirty++;
+  // saving the cursors position before search
+  ptrdiff_t saved_cx = E.cx;
+  ptrdiff_t saved_cy = E.cy;
+  ptrdiff_t saved_coloff = E.coloff;
+  ptrdiff_t saved_rowoff = E.rowoff;
+  ptrdiff_t saved_wrapoff = E.wrapoff;
+  char *query = editorPrompt(editorFindPrompt(NULL), 
+    editorFindCallBack);
+  if (query == NULL) {
+    // restoring the cursor position before search
+    E.cx = saved_cx;
+    E.cy = saved_cy;
+    E.coloff = saved_coloff;
+    E.rowoff = saved_rowoff;
+    E.wrapoff = saved_wrapoff;
+  }
+  return query;
 }
 
-void editorFreeRow(erow *row) {
-  free(row->render);
-  free(row->chars);
-  free(row->highlight);
+void editorFind() {
+  free(editorFindQuery());
 }
 
-void editorDelRow(int at) {
-  if (at<0 || at>=E.numrows) {
+void editorReplace() {
+  /* replacing every match of a query in the file. the find prompt
+     asks for the query with its modes, another prompt for what 
+     goes in its place
+  */
+  char *query = editorFindQuery();
+  if (query == NULL) {
     return;
   }
-  editorFreeRow(&E.row[at]);
-  memmove(&E.row[at], &E.row[at+1], sizeof(erow)*(E.numrows-at-1));
-  for (int j=at; j<E.numrows-1; j++) {
-    /* Updating index of the row because of the deletion
-       of an existing row
-    */
-    E.row[j].index--;
-  }
-  E.numrows--;
-  E.dirty++;
-}
-
-void editorRowInsertChar(erow *row, int at, int c) {
-  if (at<0 || at>row->size) {
-    at = row->size;
+  editorSearch search = {0};
+  if (editorSearchCompile(&search, query, E.searchflags) == -1) {
+    editorSetStatusMessage("Replace: %s", search.error);
+    editorSearchFree(&search);
+    free(query);
+    return;
   }
-  row->chars = realloc(row->chars, row->size + 2);
-  /* memmove is safe to use than memcpy when source & 
-     destination of an array overlaps with each other 
-  */
-  memmove(&row->chars[at+1], &row->chars[at], row->size - at+1);
-  row->size++;
-  row->chars[at] = c;
-  // updating render & rsize
-  editorUpdateRow(row);
-  E.dirty++;
-}
-
-void editorRowAppendString(erow *row, char *s, size_t len) {
-  row->chars = realloc(row->chars, row->size+len+1);
-  // appending the string in the row
-  memcpy(&row->chars[row->size], s, len);
-  // updating the size
-  row->size += len;
-  row->chars[row->size] = '\0';
-  editorUpdateRow(row);
-  E.dirty++;
-}
-
-void editorRowDelChar(erow *row, int at) {
-  if (at < 0 || at >= row->size) {
+  char prompt[80];
+  snprintf(prompt, sizeof(prompt), "Replace %.30s with: %%s (ESC to "
+    "cancel)", query);
+  // nothing in its place deletes the matches
+  char *with = editorPromptFor(prompt, NULL, 1);
+  if (with == NULL) {
+    editorSearchFree(&search);
+    free(query);
     return;
   }
-  // overwrite the deleted character with the next character
-  memmove(&row->chars[at], &row->chars[at+1], row->size - at);
-  // then decrement the size of the row
-  row->size--;
-  editorUpdateRow(row);
-  E.dirty++;
+  ptrdiff_t rows;
+  ptrdiff_t replaced = editorReplaceAll(&search, with, &rows);
+  editorSetStatusMessage("Replaced %td matches on %td lines", replaced, 
+    rows);
+  editorSearchFree(&search);
+  free(query);
+  free(with);
 }
 
-/*** editor operations ***/
+/*** grep ***/
 
-void editorInsertChar (int c) {
-  if (E.cy == E.numrows) {
-    /* appending a blank row after the end of a line to take 
-       the character from the user
-    */
-    editorInsertRow(E.numrows,"", 0);
-  }
-  editorRowInsertChar(&E.row[E.cy], E.cx, c);
-  /* after taking the character, moving forward the cursor
-     to take the next character right after the previous one
+void editorGrepFiles() {
+  /* grepping the files under the working directory for a query, 
+     with the modes of the find prompt. what it finds shows up a 
+     line at a time in a buffer of its own, the one of a grep before
+     gets reused when it's shown
   */
-  E.cx++;
-}
-
-void editorInsertNewLine() {
-  if (E.cx == 0) {
-    /* if the cursor at the beginning of a line, then 
-       pressing Enter will create a blank line before
-       that line
-    */
-    editorInsertRow(E.cy, "", 0);
+  if (scratch_under) {
+    editorMemoryView();
+  }
+  char prompt[80];
+  snprintf(prompt, sizeof(prompt), "Grep%s%s%s: %%s (ESC to cancel)",
+    (E.searchflags & SEARCH_IGNORE_CASE) ? " [Aa]" : "",
+    (E.searchflags & SEARCH_WHOLE_WORD) ? " [word]" : "",
+    (E.searchflags & SEARCH_REGEX) ? " [regex]" : "");
+  char *query = editorPrompt(prompt, NULL);
+  if (query == NULL) {
+    return;
   }
-  else {
-    erow *row = &E.row[E.cy];
-    /* passing the characters of the right of cursor
-       to the new line
-    */
-    editorInsertRow(E.cy+1, &row->chars[E.cx], row->size - E.cx);
-    row = &E.row[E.cy];
-    row->size = E.cx;
-    row->chars[row->size] = '\0';
-    editorUpdateRow(row);
+  editorSearch search = {0};
+  if (editorSearchCompile(&search, query, E.searchflags) == -1) {
+    editorSetStatusMessage("Grep: %s", search.error);
+    editorSearchFree(&search);
+    free(query);
+    return;
+  }
+  editorSearchFree(&search);
+  if (E.grep == NULL) {
+    struct editorConfig *editor = editorBufferNew();
+    editor->searchflags = E.searchflags;
+    editorBufferShow(editorBufferAdd(editor));
   }
-  E.cy++;
-  E.cx=0;
+  editorGrepStart(query);
 }
 
-void editorDelChar() {
-  if (E.cy == E.numrows) {
-    /* return immediately if the cursor gets to 
-       the end of the file
-    */
-    return;
-  }
-  if (E.cx == 0 && E.cy == 0) {
-    /* return immediately if the cursor is at the 
-       beginning of the first line
-    */
+void editorGrepOpen() {
+  /* Enter on a result shows its file at its line & at the first 
+     match in it. a file open in a buffer already gets shown there, 
+     the results stay in theirs
+  */
+  long line = 0;
+  char *path = editorGrepResult(&line);
+  if (path == NULL) {
     return;
   }
-  erow *row = &E.row[E.cy];
-  if (E.cx > 0) {
-    editorRowDelChar(row, E.cx - 1);
-    E.cx--;
+  editorSearch search = {0};
+  editorSearchCompile(&search, E.grep->query, E.grep->flags);
+  int k = editorBufferFile(path);
+  if (k == -1) {
+    editorSetStatusMessage("Can't open %.40s: %s", path, strerror(errno));
   }
   else {
-    /* setting the cursor at the end of the previous row
-       before appending
-    */
-    E.cx = E.row[E.cy-1].size;
-    editorRowAppendString(&E.row[E.cy-1], row->chars, row->size);
-    editorDelRow(E.cy);
-    E.cy--;
+    editorBufferShow(k);
+    E.cy = (line - 1 < E.numrows) ? line - 1 : E.numrows;
+    if (E.cy < E.numrows) {
+      erow *opened = &E.row[E.cy];
+      ptrdiff_t at = editorSearchForward(&search, opened->chars, 
+        opened->size, 0);
+      E.cx = (at == -1) ? 0 : at;
+    }
+    // showing the line in the middle of the screen
+    E.rowoff = E.cy - E.screenrows/2;
+    if (E.rowoff < 0) {
+      E.rowoff = 0;
+    }
   }
+  editorSearchFree(&search);
+  free(path);
 }
 
 /*** file i/o ***/
 
-char *editorRowsToString(int *buflen) {
-  int totallen=0;
-  // getting the total size to be copied
-  for (int j=0; j<E.numrows; j++) {
-    totallen = totallen + E.row[j].size + 1;
-  }
-  *buflen = totallen;
-  char *buf = malloc(totallen);
-  char *p = buf;
-  for (int j=0; j<E.numrows; j++) {
-    memcpy(p, E.row[j].chars, E.row[j].size);
-    p = p + E.row[j].size;
-    // appending the new line character after each row
-    *p = '\n';
-    p++;
-  }
-  return buf;
-  // the caller function will free the buf
-}
-
-void editorOpen(char *filename) {
-  free(E.filename);
-  E.filename = strdup(filename);
-  editorSelectSyntaxHighlight();
-  // taking a filename & opens it for reading by fopen()
-  FILE *fp = fopen(filename, "r");
-  if (!fp) {
-    die("fopen");
-  }
-  char *line = NULL;
-  size_t linecap = 0;
-  ssize_t len;
-  /* getting the line & len from getline() instead of hardcoded
-     getline returns the length of the line it reads
-     or -1 when it is the end of the file i.e. no more lines
-     to read
-  */
-  while ((len = getline(&line, &linecap, fp)) != -1) {
-    while (len>0 && (line[len-1]=='\n' || line[len-1]=='\r')) {
-      /* stripping the newline '\n' & carriage return '\r'
-         from the line we consider. It's a one liner. so it will
-         be redundant to include newline or carriage return
-      */
-      len--;
-    }
-    editorInsertRow(E.numrows, line, len);
-  }
-  free(line);
-  fclose(fp);
-  E.dirty = 0;
-}
-
 void editorSave() {
   if (E.filename == NULL) {
     E.filename = editorPrompt("Save as: %s (ESC to cancel)", NULL);
@@ -791,162 +681,533 @@ void editorSave() {
     }
     editorSelectSyntaxHighlight();
   }
-  int len;
-  char *buf = editorRowsToString(&len);
-  /* opening E.filename
-     if it's new, then create a file. that's why O_CREAT used
-     if it exists, then open the file for read and write.
-     Thats's why O_RDWR is used.
-     OCREAT's permission here is  0644.
-     The 0644 permits that the owner can read and write 
-     whenever they want
-     otherwise the user can only read
+  editorSaveFile();
+}
+
+void editorProfileToggle() {
+  /* Ctrl-Y turns the profiler on, & off again asking for a file to
+     save the trace of the frames in between to
   */
-  int fd = open(E.filename, O_RDWR | O_CREAT, 0644);
-  if (fd != -1) {
-    if (ftruncate(fd, len) != -1) {
-      if (write(fd, buf, len) == len) {
-        close(fd);
-        free(buf);
-        E.dirty = 0;
-        editorSetStatusMessage("%d bytes written to disk", len);
-        return;
-      }
-    }
-    close(fd);
+  if (!profiler.on) {
+    editorProfileStart();
+    editorSetStatusMessage("Profiling, Ctrl-Y to stop");
+    return;
   }
-  free(buf);
-  editorSetStatusMessage("Can't save !! I/O error: %s", 
-    strerror(errno));
+  // the frames of the prompt stay out of the trace
+  profiler.on = 0;
+  char *filename = editorPrompt("Save trace as: %s (ESC to discard)", 
+    NULL);
+  if (filename == NULL) {
+    editorSetStatusMessage("Trace discarded");
+  }
+  else if (editorProfileWrite(filename) == -1) {
+    editorSetStatusMessage("Can't save the trace !! I/O error: %s",
+      strerror(errno));
+  }
+  else if (profiler.dropped > 0) {
+    editorSetStatusMessage("%td trace events written, %td dropped",
+      profiler.eventcount, profiler.dropped);
+  }
+  else {
+    editorSetStatusMessage("%td trace events written to %.20s", 
+      profiler.eventcount, filename);
+  }
+  free(filename);
+  editorProfileStop();
 }
 
-/*** find ***/
+/*** memory ***/
 
-void editorFindCallBack(char *query, int key) {
-  /* last match is the index in the row that have
-     searched previous query
+void editorMemoryView() {
+  /* Ctrl-U shows where the memory of the buffer goes in a scratch
+     buffer of its own. Ctrl-U or Ctrl-Q there goes back to the file
   */
-  static int last_match = -1;
-  // direction 1 means forward search, 
-  // diredtion 2 means backward search
-  static int direction = 1;
-  static int saved_highlight_line;
-  static char *saved_highlight = NULL;
-  if (saved_highlight) {
-    memcpy(E.row[saved_highlight_line].highlight, saved_highlight, 
-      E.row[saved_highlight_line].rsize);
-    free(saved_highlight);
-    saved_highlight = NULL;
+  if (scratch_under) {
+    struct editorConfig *under = scratch_under;
+    // the screen may have been resized meanwhile
+    under->screenrows = E.screenrows;
+    under->screencolumns = E.screencolumns;
+    scratch_under = NULL;
+    codibleFree(codible_editor);
+    codibleSelect(under);
+    return;
   }
-  /* stopping incremental search if the user pressed 
-     ENTER or ESC key
+  size_t len;
+  char *report = editorMemoryReport(&len);
+  struct editorConfig *scratch = codibleNew();
+  scratch->screenrows = E.screenrows;
+  scratch->screencolumns = E.screencolumns;
+  scratch->input = E.input;
+  scratch->refresh = E.refresh;
+  scratch->idle = E.idle;
+  scratch_under = codible_editor;
+  codibleSelect(scratch);
+  char *line = report;
+  char *newline;
+  while ((newline = memchr(line, '\n', report + len - line))) {
+    editorInsertRow(E.numrows, line, newline - line);
+    line = newline + 1;
+  }
+  free(report);
+  E.dirty = 0;
+  editorSetStatusMessage("Ctrl-U to go back to the file");
+}
+
+/*** panes ***/
+
+editorPane *editorPaneNew(editorPane *parent) {
+  editorPane *pane = calloc(1, sizeof(editorPane));
+  if (pane == NULL) {
+    die("calloc");
+  }
+  pane->parent = parent;
+  return pane;
+}
+
+void editorPaneForget(editorPane *pane) {
+  // what the lines of the pane showed, they all get drawn again
+  for (int y=0; y<pane->shownrows; y++) {
+    abFree(&pane->shown[y]);
+  }
+  free(pane->shown);
+  pane->shown = NULL;
+  pane->shownrows = 0;
+}
+
+editorPane *editorPaneFirst(editorPane *pane) {
+  while (pane->split) {
+    pane = pane->first;
+  }
+  return pane;
+}
+
+editorPane *editorPaneNext(editorPane *pane) {
+  // the pane after this one, or the first one after the last
+  while (pane->parent && pane == pane->parent->second) {
+    pane = pane->parent;
+  }
+  return editorPaneFirst(pane->parent ? pane->parent->second : pane);
+}
+
+void editorPaneSave(editorPane *pane) {
+  // parking the place in the file of the editor selected in a pane
+  pane->editor = codible_editor;
+  pane->cx = E.cx;
+  pane->cy = E.cy;
+  pane->rowoff = E.rowoff;
+  pane->coloff = E.coloff;
+  pane->wrapoff = E.wrapoff;
+}
+
+void editorPaneLoad(editorPane *pane) {
+  /* selecting the editor of a pane at the place it was parked at, 
+     with the size of the pane. an edit in another pane may have 
+     taken rows away from under it since
   */
-  if (key == '\r' || key == '\x1b') {
-    /* resetting last_match and direction to get ready
-       for next search operation
-    */
-    last_match = -1;
-    direction = 1;
+  codibleSelect(pane->editor);
+  E.cy = (pane->cy <= E.numrows) ? pane->cy : E.numrows;
+  E.cx = pane->cx;
+  editorClampCursor();
+  E.rowoff = pane->rowoff;
+  E.coloff = pane->coloff;
+  E.wrapoff = pane->wrapoff;
+  E.screenrows = (pane->rows > 1) ? pane->rows - 1 : 1;
+  E.screencolumns = pane->columns;
+}
+
+void editorPaneLayout(editorPane *pane, int top, int left, int rows, 
+  int columns) {
+  /* the halves of a split pane get half of its place each, a column
+     between the ones side by side
+  */
+  pane->top = top;
+  pane->left = left;
+  pane->rows = rows;
+  pane->columns = columns;
+  if (pane->split == SPLIT_ROWS) {
+    editorPaneLayout(pane->first, top, left, rows/2, columns);
+    editorPaneLayout(pane->second, top + rows/2, left, rows - rows/2, 
+      columns);
+  }
+  else if (pane->split == SPLIT_COLUMNS) {
+    int half = (columns - 1)/2;
+    editorPaneLayout(pane->first, top, left, rows, half);
+    editorPaneLayout(pane->second, top, left + half + 1, rows, 
+      columns - half - 1);
+  }
+}
+
+void editorPanesLayout() {
+  // fitting the panes into the terminal, above the message bar
+  editorPaneSave(pane_focus);
+  editorPaneLayout(pane_root, 0, 0, screen_rows - 1, screen_columns);
+  editorPaneLoad(pane_focus);
+  screen_stale = 1;
+}
+
+void editorPaneSplit(int split) {
+  /* splitting the focused pane in two views of its buffer, the 
+     focus staying in the first
+  */
+  if (scratch_under) {
+    editorMemoryView();
+  }
+  editorPane *pane = pane_focus;
+  if ((split == SPLIT_ROWS && pane->rows < 4) || 
+    (split == SPLIT_COLUMNS && pane->columns < 3)) {
+    editorSetStatusMessage("The pane is too small to split");
     return;
   }
-  else if (key == ARROW_RIGHT || key == ARROW_DOWN) {
-    direction = 1;
+  editorPaneSave(pane);
+  editorPaneForget(pane);
+  pane->first = editorPaneNew(pane);
+  pane->second = editorPaneNew(pane);
+  editorPaneSave(pane->first);
+  editorPaneSave(pane->second);
+  pane->split = split;
+  pane_focus = pane->first;
+  editorPanesLayout();
+}
+
+void editorPaneClose() {
+  // the other half of the split the focused pane is in takes its place
+  if (scratch_under) {
+    editorMemoryView();
   }
-  else if (key == ARROW_LEFT || key == ARROW_UP) {
-    direction = -1;
+  editorPane *pane = pane_focus, *parent = pane->parent;
+  if (parent == NULL) {
+    editorSetStatusMessage("It's the only pane");
+    return;
   }
-  else {
-    last_match = -1;
-    direction = 1;
+  editorPane *other = (pane == parent->first) ? parent->second : 
+    parent->first;
+  editorPaneForget(pane);
+  free(pane);
+  editorPaneForget(other);
+  editorPane *grandparent = parent->parent;
+  *parent = *other;
+  parent->parent = grandparent;
+  if (parent->split) {
+    parent->first->parent = parent;
+    parent->second->parent = parent;
+  }
+  free(other);
+  pane_focus = editorPaneFirst(parent);
+  editorPaneLoad(pane_focus);
+  editorPanesLayout();
+}
+
+void editorPaneFocusNext() {
+  if (scratch_under) {
+    editorMemoryView();
   }
-  if (last_match == -1) {
-    direction = 1;
+  editorPaneSave(pane_focus);
+  pane_focus = editorPaneNext(pane_focus);
+  editorPaneLoad(pane_focus);
+}
+
+void editorPaneCommand() {
+  /* Ctrl-X then a key, the keys of Emacs: 2 splits the pane in one
+     above the other, 3 in two side by side, o goes to the next pane
+     & 0 closes the pane
+  */
+  editorSetStatusMessage("Ctrl-X: 2 split, 3 split side by side, "
+    "o other pane, 0 close pane");
+  editorRefreshScreen();
+  int c = editorReadKey();
+  editorSetStatusMessage("");
+  switch (c) {
+    case '2':
+      editorPaneSplit(SPLIT_ROWS);
+      break;
+    case '3':
+      editorPaneSplit(SPLIT_COLUMNS);
+      break;
+    case 'o':
+      editorPaneFocusNext();
+      break;
+    case '0':
+      editorPaneClose();
+      break;
   }
-  // current is the current row we are searching
-  int current = last_match;
-  for (int i=0; i<E.numrows; i++) {
-    current = current + direction;
-    if (current == -1) {
-      current = E.numrows - 1;
+}
+
+/*** buffers ***/
+
+size_t editorBufferDropped(struct editorConfig *editor) {
+  // the bytes of a buffer editorDropRenders() would free
+  return editor->memory.bytes[MEMORY_RENDER] + 
+    editor->memory.bytes[MEMORY_HIGHLIGHT] + 
+    editor->memory.bytes[MEMORY_WRAPS];
+}
+
+int editorBufferCurrent() {
+  // the buffer of the editor selected, -1 for a scratch buffer
+  for (int k=0; k<buffercount; k++) {
+    if (buffers[k].editor == codible_editor) {
+      return k;
     }
-    else if (current == E.numrows) {
-      current = 0;
+  }
+  return -1;
+}
+
+int editorBufferHidden(int k) {
+  // whether no pane shows buffer k
+  if (buffers[k].editor == codible_editor) {
+    return 0;
+  }
+  editorPane *first = editorPaneFirst(pane_root), *pane = first;
+  do {
+    if (pane != pane_focus && pane->editor == buffers[k].editor) {
+      return 0;
     }
-    erow *row = &E.row[current];
-    // using strstr() to find if query is a substring of the current row
-    char *match = strstr(row->render, query);
-    if (match) {
-      last_match = current;
-      E.cy = current;
-      E.cx = editorRowRxToCx(row, match-row->render);
-      /* the matching line will always be on top by setting 
-         the rowoff very bottom of the file
-      */
-      E.rowoff = E.numrows;
-      saved_highlight_line = current;
-      saved_highlight = malloc(row->rsize);
-      memcpy(saved_highlight, row->highlight, row->rsize);
-      memset(&row->highlight[match - row->render], 
-        HL_MATCH, strlen(query));
-      break;
+    pane = editorPaneNext(pane);
+  } while (pane != first);
+  return 1;
+}
+
+void editorBufferTrim() {
+  /* the buffers that aren't shown drop what they can render again,
+     the ones shown longest ago first, until they keep no more than
+     CODIBLE_HIDDEN_MEMORY between them
+  */
+  struct editorConfig *shown = codible_editor;
+  /* which buffers are hidden & what they'd free is worked out before
+     any of them gets selected, editorBufferHidden() goes by the one
+     that is
+  */
+  int *order = editorMallocArray(buffercount, sizeof(int));
+  int count = 0;
+  size_t hidden = 0;
+  for (int k=0; k<buffercount; k++) {
+    if (editorBufferHidden(k) && editorBufferDropped(buffers[k].editor)) {
+      // kept in the order they were shown, the oldest first
+      int j = count++;
+      while (j > 0 && buffers[order[j-1]].shown > buffers[k].shown) {
+        order[j] = order[j-1];
+        j--;
+      }
+      order[j] = k;
+      hidden += editorBufferDropped(buffers[k].editor);
     }
   }
+  for (int j=0; j<count && hidden > CODIBLE_HIDDEN_MEMORY; j++) {
+    hidden -= editorBufferDropped(buffers[order[j]].editor);
+    codibleSelect(buffers[order[j]].editor);
+    editorDropRenders();
+  }
+  codibleSelect(shown);
+  free(order);
 }
 
-void editorFind() {
-  // saving the cursors position before search
-  int saved_cx = E.cx;
-  int saved_cy = E.cy;
-  int saved_coloff = E.coloff;
-  int saved_rowoff = E.rowoff;
-  char *query = editorPrompt("Search: %s (Use ESC/Arrows/ENTER)", editorFindCallBack);
-  if (query) {
-    free(query);
+int editorBufferAdd(struct editorConfig *editor) {
+  buffers = editorReallocArray(buffers, buffercount + 1, 
+    sizeof(editorBuffer));
+  buffers[buffercount].editor = editor;
+  buffers[buffercount].shown = 0;
+  return buffercount++;
+}
+
+void editorBufferShow(int k) {
+  /* switching the focused pane to buffer k is selecting its editor,
+     which takes the size of the pane along
+  */
+  struct editorConfig *editor = buffers[k].editor;
+  editor->screenrows = E.screenrows;
+  editor->screencolumns = E.screencolumns;
+  codibleSelect(editor);
+  pane_focus->editor = editor;
+  buffers[k].shown = ++buffershown;
+  editorBufferTrim();
+}
+
+void editorBufferSwitch(int direction) {
+  // Ctrl-N & Ctrl-B show the next & the previous buffer
+  if (scratch_under) {
+    editorMemoryView();
   }
-  else {
-    // restoring the cursor position before search
-    E.cx = saved_cx;
-    E.cy = saved_cy;
-    E.coloff = saved_coloff;
-    E.rowoff = saved_rowoff;
+  if (buffercount < 2) {
+    editorSetStatusMessage("No other buffer, Ctrl-O opens a file");
+    return;
   }
+  editorBufferShow((editorBufferCurrent() + direction + buffercount) %
+    buffercount);
 }
 
-/*** append buffer ***/
+int editorSameFile(const char *a, const char *b) {
+  /* two names of one file: ./a.c, a.c & a symbolic link to it all
+     stat() to its device & inode. a file that isn't there yet only 
+     has its name to go by
+  */
+  struct stat sa, sb;
+  if (stat(a, &sa) == 0 && stat(b, &sb) == 0) {
+    return sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+  }
+  return strcmp(a, b) == 0;
+}
 
-struct abuf {
-  char *b;
-  int len;
-};
+struct editorConfig *editorBufferNew() {
+  // an empty buffer, drawn & fed keys like the one shown
+  struct editorConfig *editor = codibleNew();
+  editor->screenrows = E.screenrows;
+  editor->screencolumns = E.screencolumns;
+  editor->input = E.input;
+  editor->refresh = E.refresh;
+  editor->idle = E.idle;
+  return editor;
+}
 
-#define ABUF_INIT {NULL, 0} 
-/* initially pointing to the empty buffer
-   worked as a constructor
-*/
+int editorBufferFile(char *filename) {
+  /* the buffer a file is open in, a new one if it's in none yet.
+     -1 with errno set if it can't be opened
+  */
+  for (int k=0; k<buffercount; k++) {
+    char *open = buffers[k].editor->filename;
+    if (open && editorSameFile(open, filename)) {
+      return k;
+    }
+  }
+  struct editorConfig *editor = editorBufferNew();
+  struct editorConfig *shown = codible_editor;
+  codibleSelect(editor);
+  int opened = editorOpen(filename);
+  int error = errno;
+  codibleSelect(shown);
+  if (opened == -1) {
+    codibleFree(editor);
+    errno = error;
+    return -1;
+  }
+  return editorBufferAdd(editor);
+}
 
-void abAppend(struct abuf *ab, const char *s, int len) {
-  char *new = realloc(ab->b, ab->len + len);
-  if (new == NULL) {
+void editorBufferOpen() {
+  /* Ctrl-O opens a file in a buffer of its own, or shows the buffer
+     it's open in already
+  */
+  if (scratch_under) {
+    editorMemoryView();
+  }
+  char *filename = editorPrompt("Open: %s (ESC to cancel)", NULL);
+  if (filename == NULL) {
     return;
   }
-  memcpy(&new[ab->len],s,len); 
-  // copy the string s at the end of the buffer
-  // updating pointer and length
-  ab->b = new;
-  ab->len += len;
+  int k = editorBufferFile(filename);
+  if (k == -1) {
+    editorSetStatusMessage("Can't open %.40s: %s", filename, 
+      strerror(errno));
+  }
+  else {
+    editorBufferShow(k);
+  }
+  free(filename);
 }
 
-void abFree(struct abuf *ab) {
-  free(ab->b);
+void editorBufferClose() {
+  /* closing the buffer shown for the one after it, or before the 
+     last. the other panes showing it show that one too
+  */
+  struct editorConfig *closing = codible_editor;
+  int current = editorBufferCurrent();
+  memmove(&buffers[current], &buffers[current+1], 
+    sizeof(editorBuffer)*(buffercount - current - 1));
+  buffercount--;
+  editorBufferShow(current < buffercount ? current : buffercount - 1);
+  editorPane *first = editorPaneFirst(pane_root), *pane = first;
+  do {
+    if (pane->editor == closing) {
+      editorPaneSave(pane);
+    }
+    pane = editorPaneNext(pane);
+  } while (pane != first);
+  codibleFree(closing);
 }
 
 /*** output ***/
 
+int editorSyntaxToColor(int highlight) {
+  switch (highlight) {
+    case HL_COMMENT:
+    case HL_MLCOMMENT:
+      // single line comments & multi line comments coloring with cyan
+      return 36;
+    case HL_KEYWORD1:
+      // keywords coloring with yellow
+      return 33;
+    case HL_KEYWORD2:
+      // keywords coloring with green
+      return 32;
+    case HL_STRING:
+      // strings coloring with magenta
+      return 35;
+    case HL_NUMBER:
+    // digits coloring with red
+      return 31;
+    case HL_MATCH:
+    // matched string coloring with blue
+      return 34;
+    case HL_MATCH_CURRENT:
+    // the match the cursor is on gets a blue background
+      return 44;
+    default:
+      return 37;
+  }
+}
+
+void editorScrollWrapped() {
+  /* scrolling by visual lines. only the rows between the top of 
+     the screen & the cursor get wrapped, giving up as soon as the
+     cursor turns out to be a screen or more away
+  */
+  ptrdiff_t line = 0;
+  erow *row = (E.cy < E.numrows) ? &E.row[E.cy] : NULL;
+  if (row) {
+    line = editorRowVisualLine(row, E.rx);
+  }
+  E.coloff = 0;
+  if (E.rowoff < E.numrows && 
+    E.wrapoff >= editorRowVisualLines(&E.row[E.rowoff])) {
+    // the top row got shorter since it was scrolled to
+    E.wrapoff = editorRowVisualLines(&E.row[E.rowoff]) - 1;
+  }
+  if (E.cy < E.rowoff || (E.cy == E.rowoff && line < E.wrapoff)) {
+    E.rowoff = E.cy;
+    E.wrapoff = line;
+  }
+  int y = 0;
+  ptrdiff_t filerow = E.rowoff, fileline = E.wrapoff;
+  while ((filerow < E.cy || (filerow == E.cy && fileline < line)) && 
+
+    y < E.screenrows) {
+    editorWrapStep(&filerow, &fileline, 1);
+    y++;
+  }
+  if (y >= E.screenrows) {
+    // the cursor goes to the last line of the screen
+    filerow = E.cy;
+    fileline = line;
+    for (y=0; y<E.screenrows-1; y++) {
+      if (!editorWrapStep(&filerow, &fileline, -1)) {
+        break;
+      }
+    }
+    E.rowoff = filerow;
+    E.wrapoff = fileline;
+  }
+  E.cursory = y;
+  // both are on the screen, so they fit in an int
+  E.cursorx = row ? (int)(E.rx - editorRowWrapStart(row, line)) : 0;
+}
+
 void editorScroll() {
   E.rx = 0;
   if (E.cy < E.numrows) {
     E.rx = editorRowCxToRx(&E.row[E.cy], E.cx);
   }
+  if (E.wrap) {
+    editorScrollWrapped();
+    return;
+  }
   if (E.cy < E.rowoff) {
     // checking if the cursor is within the visible window
     E.rowoff = E.cy;
@@ -969,6 +1230,154 @@ void editorScroll() {
     */
     E.coloff = E.rx - E.screencolumns + 1;
   }
+  E.cursory = (int)(E.cy - E.rowoff);
+  E.cursorx = (int)(E.rx - E.coloff);
+}
+
+int editorDrawRenderColumns(struct abuf *ab, erow *row, ptrdiff_t col, 
+  int len) {
+  /* drawing the screen columns [col, col+len) of a row, returns how
+     many of them it took
+  */
+  if (row->checkpointcount) {
+    // a long row only renders the columns around the visible ones
+    editorRowRenderWindow(row, col, len);
+  }
+  else if (row->render == NULL) {
+    // a hidden buffer dropped it, see editorBufferTrim()
+    editorRowRender(row);
+  }
+  // the matches of the find prompt show in the colors of their own
+  unsigned char *found = editorFindHighlight(row);
+  unsigned char *highlight = found ? found : row->highlight;
+  ptrdiff_t end = col + len;
+  // starting at the character that shows column col
+  ptrdiff_t cx = editorRowRxToCx(row, col);
+  ptrdiff_t x = editorRowCxToRx(row, cx);
+  ptrdiff_t j = editorRowCxToRb(row, cx) - editorRowCxToRb(row, row->cwin);
+  int current_color = -1;
+  // whether the last character that takes columns made it on screen
+  int drawn = 0;
+  while (j < row->rsize) {
+    int cp;
+    int bytes = editorUtf8Decode(&row->render[j], row->rsize - j, &cp);
+    int width = editorCharWidth(cp);
+    if (x >= end && width > 0) {
+      break;
+    }
+    int visible = (x >= col && x + width <= end);
+    if (!visible || (width == 0 && !drawn)) {
+      /* a character cut by the edge of the screen shows as spaces,
+         a combining mark whose character isn't drawn not at all
+      */
+      ptrdiff_t from = (x < col) ? col : x;
+      ptrdiff_t to = (x + width > end) ? end : x + width;
+      for (ptrdiff_t k=from; k<to; k++) {
+        abAppend(ab, " ", 1);
+      }
+    }
+    else if (cp < 32 || cp == 127 || (cp >= 0x80 && cp < 0xA0)) {
+      /* control characters & bytes that aren't valid UTF-8 (cp is
+         -1 for them) get an inverted symbol
+      */
+      char sym = (cp >= 0 && cp <= 26) ? '@' + cp : '?';
+      // switching to inverted colors
+      abAppend(ab, "\x1b[7m", 4);
+      abAppend(ab, &sym, 1);
+      // reverting back to normal colors
+      abAppend(ab, "\x1b[m", 3);
+      if (current_color != -1) {
+        char buf[16];
+        int clen = snprintf(buf,sizeof(buf),"\x1b[%dm",current_color);
+        abAppend(ab, buf, clen);
+      }
+    }
+    else if (highlight[j] == HL_NORMAL) {
+      if (current_color != -1) {
+        abAppend(ab, "\x1b[m", 3);
+        current_color = -1;
+      }
+      abAppend(ab, &row->render[j], bytes);
+    }
+    else {
+      int color = editorSyntaxToColor(highlight[j]);
+      if (color != current_color) {
+        current_color = color;
+        char buffer[16];
+        /* resetting first, so the background of the current match
+           doesn't stay on
+        */
+        int colorlen = snprintf(buffer, sizeof(buffer),
+          "\x1b[0;%dm", color);
+        abAppend(ab, buffer, colorlen);
+      }
+      abAppend(ab, &row->render[j], bytes);
+    }
+    if (width > 0) {
+      drawn = visible;
+    }
+    x += width;
+    j += bytes;
+  }
+  free(found);
+  // resetting the text color to default
+  abAppend(ab, "\x1b[m", 3);
+  // the row can end before the screen does
+  ptrdiff_t taken = ((x < end) ? x : end) - col;
+  return (taken > 0) ? (int)taken : 0;
+}
+
+void editorDrawLine(struct abuf *ab, int y, struct abuf *line, int width) {
+  /* line y of the pane being drawn, cleared past the width it takes.
+     it's only written if the terminal doesn't show it already, an 
+     edit redraws the lines it changed in each pane showing them
+  */
+  editorPane *pane = pane_drawn;
+  int columns = pane ? pane->columns : E.screencolumns;
+  if (pane == NULL || pane->left + pane->columns >= screen_columns) {
+    if (width < columns) {
+      // [K escape sequence will clear the rest of the line
+      abAppend(line, "\x1b[K", 3);
+    }
+  }
+  else {
+    // a pane with another one right of it can't clear to the end
+    for (; width < columns; width++) {
+      abAppend(line, " ", 1);
+    }
+  }
+  if (pane == NULL) {
+    // drawing without panes, one line after the other
+    abAppend(ab, line->b, line->len);
+    abAppend(ab, "\r\n", 2);
+    abFree(line);
+    return;
+  }
+  if (y >= pane->shownrows) {
+    abFree(line);
+    return;
+  }
+  struct abuf *shown = &pane->shown[y];
+  if (shown->len == line->len && 
+    (line->len == 0 || memcmp(shown->b, line->b, line->len) == 0)) {
+    abFree(line);
+    return;
+  }
+  if (pane->left == 0 && screen_written >= 0 && 
+    pane->top + y == screen_written + 1) {
+    // the line under the one just written is a line feed away
+    abAppend(ab, "\r\n", 2);
+  }
+  else {
+    char position[32];
+    int len = snprintf(position, sizeof(position), "\x1b[%d;%dH", 
+      pane->top + y + 1, pane->left + 1);
+    abAppend(ab, position, len);
+  }
+  screen_written = pane->top + y;
+  abAppend(ab, line->b, line->len);
+  abFree(shown);
+  *shown = *line;
 }
 
 void editorDrawRows(struct abuf *ab) {
@@ -976,8 +1385,16 @@ void editorDrawRows(struct abuf *ab) {
      text being edited
   */
   int y;
+  // with soft wrap, a row takes one screen line per visual line
+  ptrdiff_t filerow = E.rowoff;
+  ptrdiff_t fileline = E.wrap ? E.wrapoff : 0;
   for (y=0; y<E.screenrows; y++) {
-    int filerow = y+E.rowoff;
+    // the line & the columns it takes, before it gets cleared to the end
+    struct abuf line = ABUF_INIT;
+    int width = 0;
+    if (!E.wrap) {
+      filerow = y+E.rowoff;
+    }
   if (filerow >= E.numrows) {
     // Displaying the welcome message when no file is called
     if (E.numrows==0 && y==E.screenrows/3) {
@@ -991,7 +1408,7 @@ void editorDrawRows(struct abuf *ab) {
       int padding = (E.screencolumns - welcomelen)/2;
       // centering the welcome message
       if (padding != 0) {
-	      abAppend(ab, "~", 1);
+	      abAppend(&line, "~", 1);
 	      // first character is the ~
 	      padding--;
       }
@@ -999,188 +1416,250 @@ void editorDrawRows(struct abuf *ab) {
 	      /* next spaces are filled with " " (spaces) 
            until the message character starts
         */
-	      abAppend(ab, " ", 1);
+	      abAppend(&line, " ", 1);
       }
       // changing length according to the terminal size
-      abAppend(ab, welcome, welcomelen);
+      abAppend(&line, welcome, welcomelen);
+      width = (E.screencolumns - welcomelen)/2 + welcomelen;
     }
     else {
-      abAppend(ab, "~", 1);
+      abAppend(&line, "~", 1);
+      width = 1;
     }
   }
+  else if (E.wrap) {
+    erow *row = &E.row[filerow];
+    ptrdiff_t start = editorRowWrapStart(row, fileline);
+    ptrdiff_t end = E.screencolumns + start;
+    if (fileline + 1 < editorRowVisualLines(row)) {
+      end = editorRowWrapStart(row, fileline + 1);
+    }
+    width = editorDrawRenderColumns(&line, row, start, (int)(end - start));
+    editorWrapStep(&filerow, &fileline, 1);
+  }
   else {
     // to show the remaining part of a line beyond the visible window
-    int len = E.row[filerow].rsize - E.coloff;
-    if (len < 0) {
-      /* nothing will be displayed on the line after scrolling
-         if the cursor beyond the end of the line
-      */
-      len = 0;
-    }
-    if (len > E.screencolumns) {
-      len = E.screencolumns;
-    }
-    char *c = &E.row[filerow].render[E.coloff];
-    unsigned char *highlight = &E.row[filerow].highlight[E.coloff];
-    int current_color = -1;
-    for (int j=0; j<len; j++) {
-      if (iscntrl(c[j])) {
-        char sym = (c[j] <= 26) ? '@' + c[j] : '?';
-        // switching to inverted colors
-        abAppend(ab, "\x1b[7m", 4);
-        abAppend(ab, &sym, 1);
-        // reverting back to normal colors
-        abAppend(ab, "\x1b[m", 3);
-        if (current_color != -1) {
-          char buf[16];
-          int clen = snprintf(buf,sizeof(buf),"\x1b[%dm",current_color);
-          abAppend(ab, buf, clen);
-        }
-      }
-      else if (highlight[j] == HL_NORMAL) {
-        if (current_color != -1) {
-          abAppend(ab, "\x1b[39m", 5);
-          current_color = -1;
-        }
-        abAppend(ab, &c[j], 1);
-      }
-      else {
-        int color = editorSyntaxToColor(highlight[j]);
-        if (color != current_color) {
-          current_color = color;
-          char buffer[16];
-          int colorlen = snprintf(buffer, sizeof(buffer),
-            "\x1b[%dm", color);
-          abAppend(ab, buffer, colorlen);
-        }
-        abAppend(ab, &c[j], 1);
-      }
-    }
-    // resetting the text color to default
-    abAppend(ab, "\x1b[39m", 5);
+    width = editorDrawRenderColumns(&line, &E.row[filerow], E.coloff, 
+      E.screencolumns);
   }   
-  abAppend(ab, "\x1b[K", 3);
-  // [K escape sequence will clear each line as we redraw them
-  abAppend(ab, "\r\n", 2);
+  editorDrawLine(ab, y, &line, width);
   }
 }
 
 void editorDrawStatusBar (struct abuf *ab) {
   /* making the status bar in inverted colors
-     "\x1b[7m" switches to inverted color formatting
+     "\x1b[7m" switches to inverted color formatting. it's the last
+     line of the pane
   */
-  abAppend(ab, "\x1b[7m", 4);
-  char status[80], rstatus[80];
-  int len = snprintf(status, sizeof(status), "%.20s - %d lines %s",
-    E.filename ? E.filename : "[No Name]", E.numrows,
-    E.dirty ? "(modified)" : "");
-  int rlen = snprintf(rstatus, sizeof(rstatus), "%s | %d/%d",
-    E.syntax ? E.syntax->filetype: "no filetype", 
+  struct abuf line = ABUF_INIT;
+  abAppend(&line, "\x1b[7m", 4);
+  char status[80], rstatus[80], counter[40], number[32];
+  int len;
+  if (profiler.on) {
+    /* the milliseconds each phase of the last frame took in place of
+       the file name, reading the key apart from the rest
+    */
+    double ms[PHASE_COUNT], frame = 0;
+    for (int phase=0; phase<PHASE_COUNT; phase++) {
+      ms[phase] = profiler.last[phase]/1e6;
+      frame += (phase == PHASE_READ) ? 0 : ms[phase];
+    }
+    len = snprintf(status, sizeof(status), "frame %.2fms: upd %.2f hl %.2f"
+      " scr %.2f drw %.2f wr %.2f rd %.1f", frame, ms[PHASE_UPDATE], 
+      ms[PHASE_HIGHLIGHT], ms[PHASE_SCROLL], ms[PHASE_DRAW], 
+      ms[PHASE_WRITE], ms[PHASE_READ]);
+  }
+  else {
+    // which of the buffers it is, when there's more than one
+    number[0] = '\0';
+    if (buffercount > 1 && editorBufferCurrent() != -1) {
+      snprintf(number, sizeof(number), "[%d/%d] ", 
+        editorBufferCurrent() + 1, buffercount);
+    }
+    len = snprintf(status, sizeof(status), "%s%.20s - %td lines %s",
+      number, E.filename ? E.filename : 
+      (scratch_under && editorBufferCurrent() == -1) ? "[Memory]" : 
+      E.grep ? "[Grep]" : "[No Name]", E.numrows, 
+      E.dirty ? "(modified)" : "");
+  }
+  // where the find prompt is among the matches while it's open
+  counter[0] = '\0';
+  editorFindCounter(counter, sizeof(counter));
+  int rlen = snprintf(rstatus, sizeof(rstatus), "%s%s | %td/%td", 
+
+    counter, E.syntax ? E.syntax->filetype: "no filetype", 
     E.cy+1, E.numrows);
   // restricting the characters to remain in status bar
   if (len > E.screencolumns) {
     len = E.screencolumns;
   }
-  abAppend(ab, status, len);
+  abAppend(&line, status, len);
   // filling the status bar with blank spaces
   while (len < E.screencolumns) {
     /* for printing the current line number at the very
        right side of the status bar
     */
     if (E.screencolumns - len == rlen) {
-      abAppend(ab, rstatus, rlen);
+      abAppend(&line, rstatus, rlen);
       break;
     }
     else {
-    abAppend(ab, " ", 1);
+    abAppend(&line, " ", 1);
     len++;
     }
   }
   // "\x1b[m" switches (back) to the normal text formatting
-  abAppend(ab, "\x1b[m", 3);
-  abAppend(ab, "\r\n", 2);
+  abAppend(&line, "\x1b[m", 3);
+  editorDrawLine(ab, E.screenrows, &line, E.screencolumns);
 }
 
 void editorDrawMessageBar(struct abuf *ab) {
-  // clearing the message bar
-  abAppend(ab, "\x1b[K", 3);
+  // the last line of the terminal, under all of the panes
+  struct abuf line = ABUF_INIT;
   int msglen = strlen(E.statusmessage);
   // fitting the message within the column space
-  if (msglen > E.screencolumns) {
-    msglen = E.screencolumns;
+  if (msglen > screen_columns) {
+    msglen = screen_columns;
   }
   // displaying the message if it's less than 5 second's old
   if (msglen && time(NULL) - E.statusmessage_time < 5) {
-    abAppend(ab, E.statusmessage, msglen);
+    abAppend(&line, E.statusmessage, msglen);
+  }
+  // clearing the rest of the message bar
+  abAppend(&line, "\x1b[K", 3);
+  if (message_shown.len == line.len && 
+    memcmp(message_shown.b, line.b, line.len) == 0) {
+    abFree(&line);
+    return;
   }
+  char position[32];
+  int len = snprintf(position, sizeof(position), "\x1b[%d;1H", 
+    screen_rows);
+  abAppend(ab, position, len);
+  abAppend(ab, line.b, line.len);
+  abFree(&message_shown);
+  message_shown = line;
 }
 
-void editorRefreshScreen() {
+void editorDrawSeparators(struct abuf *ab, editorPane *pane) {
+  // the column between the panes side by side
+  if (pane->split == SPLIT_NONE) {
+    return;
+  }
+  if (pane->split == SPLIT_COLUMNS) {
+    for (int y=0; y<pane->rows; y++) {
+      char separator[48];
+      int len = snprintf(separator, sizeof(separator), 
+        "\x1b[%d;%dH\x1b[7m|\x1b[m", pane->top + y + 1, 
+        pane->second->left);
+      abAppend(ab, separator, len);
+    }
+  }
+  editorDrawSeparators(ab, pane->first);
+  editorDrawSeparators(ab, pane->second);
+}
+
+void editorDrawPane(struct abuf *ab, editorPane *pane) {
+  /* the rows & status bar of a pane, scrolled to where its cursor is.
+     its buffer is selected while it's drawn
+  */
+  editorPaneLoad(pane);
+  PROFILE_BEGIN(PHASE_SCROLL);
   editorScroll();
+  PROFILE_END(PHASE_SCROLL);
+  // the rows on the screen can't wait for the idle time
+  editorHighlightStale(E.rowoff + E.screenrows, LLONG_MAX);
+  PROFILE_BEGIN(PHASE_DRAW);
+  if (pane->shownrows == 0) {
+    pane->shownrows = E.screenrows + 1;
+    pane->shown = calloc(pane->shownrows, sizeof(struct abuf));
+    if (pane->shown == NULL) {
+      die("calloc");
+    }
+  }
+  pane_drawn = pane;
+  editorDrawRows(ab);
+  editorDrawStatusBar(ab);
+  pane_drawn = NULL;
+  PROFILE_END(PHASE_DRAW);
+  editorPaneSave(pane);
+}
+
+void editorRefreshScreen() {
+  PROFILE_FRAME();
   struct abuf ab = ABUF_INIT;
   abAppend(&ab, "\x1b[?25l", 6);
   /* [?25l escape sequence used for hiding the cursor
      VT100 escape sequences will be followed
   */
-  abAppend(&ab, "\x1b[H", 3);
-  /* [H escape sequence for cursor positioning. By default,
-     at the top left of the editor
+  screen_written = -1;
+  if (screen_stale) {
+    // [2J escape sequence clears the whole terminal
+    abAppend(&ab, "\x1b[2J", 4);
+    editorPane *first = editorPaneFirst(pane_root), *pane = first;
+    do {
+      editorPaneForget(pane);
+      pane = editorPaneNext(pane);
+    } while (pane != first);
+    abFree(&message_shown);
+    message_shown = (struct abuf)ABUF_INIT;
+    editorDrawSeparators(&ab, pane_root);
+    screen_stale = 0;
+    screen_written = -1;
+  }
+  /* the other panes first, the focused one last leaves its buffer 
+     selected at the place of its cursor
   */
-  editorDrawRows(&ab);
-  editorDrawStatusBar(&ab);
+  editorPaneSave(pane_focus);
+  for (editorPane *pane = editorPaneNext(pane_focus); pane != pane_focus;
+    pane = editorPaneNext(pane)) {
+    editorDrawPane(&ab, pane);
+  }
+  editorDrawPane(&ab, pane_focus);
   editorDrawMessageBar(&ab);
   char buf[32];
   /* putting the cursor to the previous position within the 
      visible window when scroll up
   */
   snprintf(buf, sizeof(buf), "\x1b[%d;%dH", 
-    (E.cy-E.rowoff)+1, (E.rx-E.coloff)+1);
+    pane_focus->top + E.cursory+1, pane_focus->left + E.cursorx+1);
   /* add cursor to the exact position
-     E.cy+1 & E.cx+1 used to make the 0-based index to
+     E.cursory+1 & E.cursorx+1 used to make the 0-based index to
      1-based index.
      The terminal uses 1-based index but C uses 0-based index
   */
   abAppend(&ab, buf, strlen(buf));
   abAppend(&ab, "\x1b[?25h", 6);
   // [?25h escape sequence used for showing the cursor 
-  write(STDOUT_FILENO, ab.b, ab.len); 
+  PROFILE_BEGIN(PHASE_WRITE);
   // writing buffer contents to standard output
+  size_t written = 0;
+  while (written < ab.len) {
+    // a resize signal can interrupt the write part way through
+    ssize_t n = write(STDOUT_FILENO, ab.b + written, ab.len - written);
+    if (n == -1 && errno != EINTR) {
+      break;
+    }
+    if (n > 0) {
+      written += (size_t)n;
+    }
+  }
+  PROFILE_END(PHASE_WRITE);
   abFree(&ab); // freeing the memory used by abuf
 }
 
-/* A thorough knowledge of VARIADIC FUNCTION is needed !!!
-   the ... denotes the function can take any number of arguments
-*/
-void editorSetStatusMessage (const char *fmt, ...) {
-  /* there will be va_start() to denote the start 
-     of the operation and va_end() to denote the end
-     of the operation of a value type va_list.
-  */
-  va_list ap;
-  /* the last argument before the ... must be passed
-     to va_start() to get the address of the next argument.
-     Between va_start() and va_end(), there will be va_arg()
-     which will be executed on the type of the next argument.
-  */
-  va_start(ap, fmt);
-  /* storing the resulting string in E.statusmessage 
-     Here, vsnprintf() works as a va_arg();
-  */
-  vsnprintf(E.statusmessage, sizeof(E.statusmessage), fmt, ap);
-  va_end(ap);
-  // setting the current time in status message time
-  E.statusmessage_time = time(NULL);
-  /* current time can be gotten by passing NULL inside the time()
-     it will calculate the seconds have past since 
-     January 1, 1970 midnight.
-  */
-}
-
 /*** input ***/
 
 char *editorPrompt(char *prompt, void (*callback)(char *, int)) {
+  // Enter only takes what's typed if it isn't empty
+  return editorPromptFor(prompt, callback, 0);
+}
+
+char *editorPromptFor(char *prompt, void (*callback)(char *, int), 
+  int empty) {
+  // editorPrompt(), & Enter takes an empty input too if empty is set
   size_t buffersize = 128;
-  char *buffer = malloc(buffersize);
+  char *buffer = editorMallocArray(buffersize, 1);
   // initially the prompt is initialized as an empty string
   size_t bufferlen = 0;
   buffer[0] =  '\0';
@@ -1188,11 +1667,19 @@ char *editorPrompt(char *prompt, void (*callback)(char *, int)) {
   while (1) {
     editorSetStatusMessage(prompt, buffer);
     editorRefreshScreen();
+    PROFILE_BEGIN(PHASE_READ);
     int c = editorReadKey();
+    PROFILE_END(PHASE_READ);
     if (c==DEL_KEY || c==CTRL_KEY('h') || c==BACKSPACE) {
+      // dropping the continuation bytes of a UTF-8 character too
+      while (bufferlen != 0 && 
+        ((unsigned char)buffer[bufferlen-1] & 0xC0) == 0x80) {
+        bufferlen--;
+      }
       if (bufferlen != 0) {
-        buffer[--bufferlen] = '\0';
+        bufferlen--;
       }
+      buffer[bufferlen] = '\0';
     }
     /* checking for Esc key, if pressed, then the input 
        prompt will disappear
@@ -1206,7 +1693,7 @@ char *editorPrompt(char *prompt, void (*callback)(char *, int)) {
       return NULL;
     }
     else if (c == '\r') {
-      if (bufferlen != 0) {
+      if (bufferlen != 0 || empty) {
         /* when input is not empty and Enter key has been
            pressed, then the status message gets clear
         */
@@ -1217,14 +1704,16 @@ char *editorPrompt(char *prompt, void (*callback)(char *, int)) {
         return buffer;
       }
     }
-    // checking the input is a printable character or not
-    else if (!iscntrl(c) && c<128) {
+    /* checking the input is a printable character or not, keys
+       from 128 to 255 are the bytes of a UTF-8 character
+    */
+    else if (!iscntrl(c) && c<256) {
       if (bufferlen == buffersize-1) {
         /* if bufferlen reaches the maximum capacity,
            we double the capacity and reallocating it
         */
         buffersize *= 2;
-        buffer = realloc(buffer, buffersize);
+        buffer = editorReallocArray(buffer, buffersize, 1);
       }
       buffer[bufferlen++] = c;
       buffer[bufferlen] = '\0';
@@ -1235,14 +1724,64 @@ char *editorPrompt(char *prompt, void (*callback)(char *, int)) {
   }
 }
 
+void editorMoveToVisualLine(ptrdiff_t filerow, ptrdiff_t line, 
+  ptrdiff_t column) {
+  /* putting the cursor on a visual line, as close to the given
+     column of that line as its characters allow
+  */
+  E.cy = filerow;
+  if (filerow >= E.numrows) {
+    E.cx = 0;
+    return;
+  }
+  erow *row = &E.row[filerow];
+  ptrdiff_t start = editorRowWrapStart(row, line);
+  ptrdiff_t rx = start + column;
+  if (line + 1 < editorRowVisualLines(row) && 
+    rx >= editorRowWrapStart(row, line + 1)) {
+    rx = editorRowWrapStart(row, line + 1) - 1;
+  }
+  E.cx = editorRowRxToCx(row, rx);
+  if (E.cx < row->size && editorRowCxToRx(row, E.cx) < start) {
+    // a character split by the wrap belongs to the line above
+    E.cx = editorRowNextChar(row, E.cx);
+  }
+}
+
+void editorMoveVisualLine(int direction) {
+  // moving the cursor up or down by a visual line in soft wrap mode
+  ptrdiff_t filerow = E.cy, line = 0, column = 0;
+  if (E.cy < E.numrows) {
+    erow *row = &E.row[E.cy];
+    ptrdiff_t rx = editorRowCxToRx(row, E.cx);
+    line = editorRowVisualLine(row, rx);
+    column = rx - editorRowWrapStart(row, line);
+  }
+  ptrdiff_t oldrow = filerow, oldline = line;
+  while (editorWrapStep(&filerow, &line, direction)) {
+    editorMoveToVisualLine(filerow, line, column);
+    /* a visual line lying entirely within a tab can't hold the 
+       cursor, it ends up back where it was & has to go further
+    */
+    ptrdiff_t newline = 0;
+    if (E.cy < E.numrows) {
+      newline = editorRowVisualLine(&E.row[E.cy], 
+        editorRowCxToRx(&E.row[E.cy], E.cx));
+    }
+    if (E.cy != oldrow || newline != oldline) {
+      break;
+    }
+  }
+}
+
 void editorMoveCursor (int key) {
   // checking whether the cursor is in last line or not
   erow *row = (E.cy >= E.numrows) ? NULL : &E.row[E.cy];
   switch (key) {
   case ARROW_LEFT:
-    // moving the cursor left
+    // moving the cursor left by a whole character
     if (E.cx != 0) {
-      E.cx--;
+      E.cx = editorRowPrevChar(row, E.cx);
     }
     /* implementing the feature of pressing left arrow to
        go to the end of the previous line
@@ -1259,7 +1798,7 @@ void editorMoveCursor (int key) {
        character or not
     */
     if (row && E.cx < row->size) {
-      E.cx++;
+      E.cx = editorRowNextChar(row, E.cx);
     }
     /* implementing the feature of pressing right arrow
        to go to the beginning of the next line
@@ -1270,12 +1809,20 @@ void editorMoveCursor (int key) {
     }
     break;
   case ARROW_UP:
+    if (E.wrap) {
+      editorMoveVisualLine(-1);
+      break;
+    }
     // moving the cursor up
     if (E.cy != 0) {
       E.cy--;
     }
     break;
   case ARROW_DOWN:
+    if (E.wrap) {
+      editorMoveVisualLine(1);
+      break;
+    }
     // moving the cursor down
     if (E.cy < E.numrows) {
       /* checking the cursor not going down after the 
@@ -1285,32 +1832,79 @@ void editorMoveCursor (int key) {
     }
     break;
   }
-  row = (E.cy >= E.numrows) ? NULL : &E.row[E.cy];
-  int rowlen = row ? row->size : 0;
-  if (E.cx > rowlen) {
-    // limiting the cursor for not to go beyond the endline;
-    E.cx = rowlen;
+  editorClampCursor();
+}
+
+void editorGoToLine() {
+  /* jumping to a line, or to a percentage of the lines with a '%'
+     after the number, & showing it in the middle of the screen
+  */
+  char *input = editorPrompt("Go to line: %s (a line or a %%, "
+    "ESC to cancel)", NULL);
+  if (input == NULL) {
+    return;
+  }
+  char *end;
+  long number = strtol(input, &end, 10);
+  if (end == input || (*end != '\0' && strcmp(end, "%") != 0)) {
+    editorSetStatusMessage("Not a line number: %.40s", input);
+    free(input);
+    return;
+  }
+  long filerow = number - 1;
+  if (*end == '%') {
+    filerow = (number <= 0) ? 0 : (number >= 100) ? E.numrows - 1 : 
+      (long)((long long)E.numrows*number/100);
+  }
+  if (filerow >= E.numrows) {
+    filerow = E.numrows - 1;
+  }
+  E.cx = 0;
+  editorJumpToRow(filerow < 0 ? 0 : filerow);
+  E.rowoff = E.cy - E.screenrows/2;
+  if (E.rowoff < 0) {
+    E.rowoff = 0;
   }
+  E.wrapoff = 0;
+  free(input);
 }
 
 void editorProcessKeypress() {
   static int quit_times = CODIBLE_QUIT_TIMES;
   // process the keypress
+  PROFILE_BEGIN(PHASE_READ);
   int c = editorReadKey();
+  PROFILE_END(PHASE_READ);
   switch (c) {
     // case handling for "Enter" key
     case '\r':
-      editorInsertNewLine();
+      // in the results of a grep it opens the line the cursor is on
+      if (E.grep) {
+        editorGrepOpen();
+      }
+      else {
+        editorInsertNewLine();
+      }
       break;
 
     case CTRL_KEY('q'):
+      // in the memory report it only goes back to the file
+      if (scratch_under) {
+        editorMemoryView();
+        break;
+      }
       if (E.dirty && quit_times > 0) {
         editorSetStatusMessage("WARNING!!! File has unsaved"
-          " changes. Press Ctrl-Q %d more times to quit.", 
-          quit_times);
+          " changes. Press Ctrl-Q %d more times to %s.", 
+          quit_times, (buffercount > 1) ? "close it" : "quit");
         quit_times--;
         return;
       }
+      // the last buffer open is the one that quits
+      if (buffercount > 1) {
+        editorBufferClose();
+        break;
+      }
       write(STDOUT_FILENO, "\x1b[2J", 4);
       write(STDOUT_FILENO, "\x1b[H", 3);
       exit(0);
@@ -1336,6 +1930,14 @@ void editorProcessKeypress() {
       editorFind();
       break;
 
+    case CTRL_KEY('r'):
+      editorReplace();
+      break;
+
+    case CTRL_KEY('p'):
+      editorGrepFiles();
+      break;
+
     case BACKSPACE:
     case CTRL_KEY('h'):
     case DEL_KEY:
@@ -1352,25 +1954,45 @@ void editorProcessKeypress() {
 
     case PAGE_UP:
     case PAGE_DOWN:
-      {
-      // scrolling up a page by PAGE_UP
-      if (c == PAGE_UP) {
-        E.cy = E.rowoff;
-      }
-      // scrolling down a page by PAGE_DOWN
-      else if (c == PAGE_DOWN) {
-        E.cy = E.rowoff + E.screenrows - 1;
-        if (E.cy > E.numrows) {
-          E.cy = E.numrows;
+      /* a page away is one jump, not a move up or down for each 
+         line of the screen
+      */
+      if (E.wrap) {
+        /* from the top visual line of the screen, a page up, or 
+           from the bottom one a page down
+        */
+        ptrdiff_t filerow = E.rowoff, line = E.wrapoff;
+        int direction = (c == PAGE_UP) ? -1 : 1;
+        int steps = (c == PAGE_UP) ? E.screenrows : 2*E.screenrows - 1;
+        for (int y=0; y<steps; y++) {
+          if (!editorWrapStep(&filerow, &line, direction)) {
+            break;
+          }
         }
+        editorMoveToVisualLine(filerow, line, 0);
       }
-      int times = E.screenrows;
-      while (times--) {
-	      editorMoveCursor(c==PAGE_UP ? ARROW_UP : ARROW_DOWN);
+      else if (c == PAGE_UP) {
+        editorJumpToRow(E.rowoff - E.screenrows);
+      }
+      else {
+        editorJumpToRow(E.rowoff + 2*E.screenrows - 1);
       }
-    }
     break;
 
+    case FILE_START:
+      E.cx = 0;
+      editorJumpToRow(0);
+      break;
+
+    case FILE_END:
+      editorJumpToRow(E.numrows > 0 ? E.numrows - 1 : 0);
+      E.cx = (E.cy < E.numrows) ? E.row[E.cy].size : 0;
+      break;
+
+    case CTRL_KEY('g'):
+      editorGoToLine();
+      break;
+
     case ARROW_UP:
     case ARROW_DOWN:
     case ARROW_LEFT:
@@ -1378,8 +2000,47 @@ void editorProcessKeypress() {
       editorMoveCursor(c);
       break;
 
-    // Ctrl-L used to refresh the terminal window
+    case CTRL_KEY('w'):
+      // toggling soft wrap
+      E.wrap = !E.wrap;
+      E.wrapoff = 0;
+      E.coloff = 0;
+      editorSetStatusMessage("Soft wrap %s", E.wrap ? "on" : "off");
+      break;
+
+    case CTRL_KEY('t'):
+      editorIndexToggle();
+      break;
+
+    case CTRL_KEY('y'):
+      editorProfileToggle();
+      break;
+
+    case CTRL_KEY('u'):
+      editorMemoryView();
+      break;
+
+    case CTRL_KEY('o'):
+      editorBufferOpen();
+      break;
+
+    case CTRL_KEY('n'):
+      editorBufferSwitch(1);
+      break;
+
+    case CTRL_KEY('b'):
+      editorBufferSwitch(-1);
+      break;
+
+    case CTRL_KEY('x'):
+      editorPaneCommand();
+      break;
+
+    // Ctrl-L used to refresh the terminal window, all of it
     case CTRL_KEY('l'):
+      screen_stale = 1;
+      break;
+
     // case handling for "Esc" key
     case '\x1b':
       break;
@@ -1397,42 +2058,82 @@ void editorProcessKeypress() {
 /*** initialization ***/
 
 void initialEditor() {
-  E.cx = 0; 
-  // horizontal coordinate of the cursor that denotes the column
-  E.cy = 0; 
-  // vertical coordinate of the cursor that denotes the row
-  E.rx = 0; // horizontal coordinate used for rendering
-  E.rowoff = 0; // row offset
-  E.coloff = 0; // column offset
-  E.numrows = 0;
-  E.row = NULL;
-  E.dirty = 0;
-  E.filename = NULL;
-  E.statusmessage[0] = '\0';
-  E.statusmessage_time = 0;
-  E.syntax = NULL;
-  if (getWindowSize(&E.screenrows, &E.screencolumns)==-1) {
+  /* a new editor for the terminal. its keys come from stdin & it 
+     gets drawn while it searches or builds an index
+  */
+  codibleSelect(codibleNew());
+  editorBufferAdd(codible_editor);
+  E.input = STDIN_FILENO;
+  E.refresh = editorRefreshScreen;
+  E.idle = editorCheckResize;
+  die_cleanup = editorClearScreen;
+  if (getWindowSize(&screen_rows, &screen_columns)==-1) {
     // exception handling
     die("getWindowSize");
   }
-  E.screenrows = E.screenrows - 2;
+  // a single pane to begin with, the message bar under it
+  pane_root = pane_focus = editorPaneNew(NULL);
+  editorPaneSave(pane_focus);
+  editorPanesLayout();
+}
+
+int editorBatch(char *scriptname, char *filename) {
+  /* codible --batch script [file]: the commands of the script run
+     on the file without a terminal & without drawing anything. a 
+     script of "-" is read from stdin
+  */
+  struct editorConfig *editor = codibleNew();
+  FILE *script = (strcmp(scriptname, "-") == 0) ? stdin : 
+    fopen(scriptname, "r");
+  if (script == NULL) {
+    die(scriptname);
+  }
+  if (filename && codibleOpen(editor, filename) == -1) {
+    die(filename);
+  }
+  int status = codibleRunScript(editor, script, stdout);
+  if (script != stdin) {
+    fclose(script);
+  }
+  codibleFree(editor);
+  return (status == -1) ? 1 : 0;
 }
 
+/* a benchmark of the drawing can include this file & bring its own
+   main()
+*/
+#ifndef CODIBLE_NO_MAIN
 int main(int argc, char *argv[])
 {
+  if (argc >= 2 && strcmp(argv[1], "--batch") == 0) {
+    if (argc < 3) {
+      fprintf(stderr, "usage: codible --batch script [file]\n");
+      return 1;
+    }
+    return editorBatch(argv[2], (argc >= 4) ? argv[3] : NULL);
+  }
   enableRawMode();
   initialEditor(); // Initialize all fields of editorConfig
+  editorWatchResize();
   /* Checking if file passed or not. If no file is called from 
      command-line, then codible will open blank file just like Emacs
   */
-  if (argc >= 2) {
-    editorOpen(argv[1]);
+  editorSyntaxLoad();
+  if (argc >= 2 && editorOpen(argv[1]) == -1) {
+    die("fopen");
+  }
+  // an error in a syntax file is worth more than the help
+  if (E.statusmessage[0] == '\0') {
+    editorSetStatusMessage(
+      "HELP: Ctrl-S = Save | Ctrl-Q = Quit | Ctrl-F = Find");
   }
-  editorSetStatusMessage(
-    "HELP: Ctrl-S = Save | Ctrl-Q = Quit | Ctrl-F = Find");
   while (1) {
     editorRefreshScreen();
+    // the key's work, less the reading of it & any frames it draws
+    PROFILE_BEGIN(PHASE_UPDATE);
     editorProcessKeypress();
+    PROFILE_END(PHASE_UPDATE);
   }
   return 0;
-}
\ No newline at end of file
+}
+#endif
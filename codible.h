@@ -0,0 +1,59 @@
+/*** codible ***/
+
+/* the editor core for a program embedding it: a buffer without a 
+   terminal that gets opened, edited, searched & saved. every 
+   function takes the editor it works on, struct editorConfig stays 
+   opaque here. an editor is used by one thread at a time
+*/
+
+#ifndef CODIBLE_H
+#define CODIBLE_H
+
+#include <stddef.h> // size_t, ptrdiff_t reside in it
+#include <stdio.h> // FILE resides in it
+
+struct editorConfig;
+
+// modes of a search
+#define SEARCH_IGNORE_CASE (1<<0)
+#define SEARCH_WHOLE_WORD (1<<1)
+#define SEARCH_REGEX (1<<2)
+
+struct editorConfig *codibleNew();
+void codibleFree(struct editorConfig *editor);
+
+/* returning -1 with errno set when the file can't be read or 
+   written. codibleSave() writes to the file the editor opened
+*/
+int codibleOpen(struct editorConfig *editor, char *filename);
+int codibleSave(struct editorConfig *editor);
+
+// rows & columns are counted from 0, the cursor stays in the buffer
+void codibleMoveCursor(struct editorConfig *editor, ptrdiff_t row, 
+  ptrdiff_t column);
+void codibleInsertChar(struct editorConfig *editor, int c);
+void codibleInsertText(struct editorConfig *editor, const char *s, 
+  size_t len);
+void codibleDelChar(struct editorConfig *editor);
+/* the whole buffer, rows ending with '\n', to be freed by the
+   caller
+*/
+char *codibleContents(struct editorConfig *editor, size_t *len);
+
+/* replacing every match of query, returns how many there were & 
+   sets rows to the rows they were on. -1 if query doesn't compile
+*/
+ptrdiff_t codibleReplaceAll(struct editorConfig *editor, 
+  const char *query, int flags, const char *with, ptrdiff_t *rows);
+
+/* the commands of codible --batch, see README.md. returns -1 after
+   telling stderr about the first command that failed
+*/
+int codibleRunScript(struct editorConfig *editor, FILE *script, 
+  FILE *out);
+/* the background work (highlighting, counting matches, the trigram
+   index), until it's done or input comes
+*/
+void codibleIdle(struct editorConfig *editor);
+
+#endif
@@ -0,0 +1,5795 @@
+/*** includes ***/
+
+#include "codible_internal.h"
+
+/*** data ***/
+
+_Thread_local struct editorConfig *codible_editor;
+
+editorSearchPool search_pool = {.jobs = PTHREAD_MUTEX_INITIALIZER};
+
+void (*die_cleanup)(void) = NULL;
+
+_Thread_local editorProfiler profiler;
+
+const char *profile_phases[PHASE_COUNT] = {
+  "read", "update", "highlight", "scroll", "draw", "write"
+};
+
+/*** filetypes ***/
+
+/* C, in the format of the syntax files. it's there without any of
+   them, & a syntax file of filetype c takes its place
+*/
+char *C_HL_syntax = 
+  "filetype c\n"
+  "files .c .h .cpp\n"
+  "comment //\n"
+  "multiline /* */\n"
+  "strings \" '\n"
+  "numbers\n"
+  "separators ,.()+-/*=~%<>[];\n"
+  "keywords switch if while for break continue return else struct\n"
+  "keywords union typedef static enum class case\n"
+  "types int long double float char unsigned signed void\n";
+
+/* highlight database, filled from the syntax files the first time a
+   file gets opened. a later one wins where two of them match a file
+*/
+struct editorSyntax *HLDB = NULL;
+int hldb_entries = 0;
+// editors on different threads may open their first files at once
+pthread_once_t hldb_once = PTHREAD_ONCE_INIT;
+
+/*** prototypes ***/
+
+ptrdiff_t editorRowSpansBefore(erow *row, ptrdiff_t cx);
+void editorRenderChars(erow *row, ptrdiff_t cstart, ptrdiff_t cend, 
+  char *render);
+void editorRegexFree(editorRegex *regex);
+editorRegex *editorRegexCompile(const char *pattern, int flags, 
+  char **literal, const char **error);
+ptrdiff_t editorRegexForward(editorSearch *search, const char *text, 
+  ptrdiff_t len, ptrdiff_t from);
+ptrdiff_t editorDfaLongest(editorRegex *regex, const char *text, 
+  ptrdiff_t len, ptrdiff_t start);
+ptrdiff_t editorRegexStarts(editorSearch *search, const char *text, 
+  ptrdiff_t len, ptrdiff_t from, ptrdiff_t filerow, 
+  editorSearchResults *results);
+void editorIndexClear(editorIndex *index);
+void editorIndexUpdateRow(erow *row);
+void editorIndexMoveRows(ptrdiff_t at, ptrdiff_t inserted, int removedid);
+
+/*** editor state ***/
+
+void die(const char *s) {
+  if (die_cleanup) {
+    die_cleanup();
+  }
+  perror(s); // returns error messages from errno global variable
+  exit(1);
+}
+
+void *editorReallocArray(void *p, ptrdiff_t count, size_t size) {
+  /* every buffer that grows with the file goes through here. a count
+     that went negative or a count*size that doesn't fit in a size_t
+     is as fatal as running out of memory, realloc() must never get
+     a wrapped around size
+  */
+  if (count < 0 || (size && (size_t)count > SIZE_MAX/size)) {
+    errno = ENOMEM;
+    die("realloc");
+  }
+  size_t bytes = (size_t)count*size;
+  p = realloc(p, bytes ? bytes : 1);
+
+  if (p == NULL) {
+    die("realloc");
+  }
+  return p;
+}
+
+void *editorMallocArray(ptrdiff_t count, size_t size) {
+  return editorReallocArray(NULL, count, size);
+}
+
+void editorMemoryAdd(int kind, void *p) {
+  // counting a block that an array of the rows is now in
+  if (p) {
+    E.memory.blocks[kind]++;
+    E.memory.bytes[kind] += malloc_usable_size(p);
+  }
+}
+
+void editorMemoryDrop(int kind, void *p) {
+  // a block of the rows about to be freed or moved
+  if (p) {
+    E.memory.blocks[kind]--;
+    E.memory.bytes[kind] -= malloc_usable_size(p);
+  }
+}
+
+void *editorRowRealloc(int kind, void *p, ptrdiff_t count, size_t size) {
+  // editorReallocArray() for the arrays of the rows
+  editorMemoryDrop(kind, p);
+  p = editorReallocArray(p, count, size);
+  editorMemoryAdd(kind, p);
+  return p;
+}
+
+void editorRowFree(int kind, void *p) {
+  editorMemoryDrop(kind, p);
+  free(p);
+}
+
+long editorMilliseconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec*1000L + ts.tv_nsec/1000000;
+}
+
+long long editorMicroseconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec*1000000LL + ts.tv_nsec/1000;
+}
+
+struct editorConfig *codibleNew() {
+  /* an empty buffer with nothing showing it. the size of the screen
+     is what the soft wrap points & the scrolling go by, a frontend
+     sets the one it has
+  */
+  struct editorConfig *editor = calloc(1, sizeof(struct editorConfig));
+  if (editor == NULL) {
+    die("calloc");
+  }
+  editor->screenrows = 24;
+  editor->screencolumns = 80;
+  editor->input = -1;
+  return editor;
+}
+
+void codibleFree(struct editorConfig *editor) {
+  // the buffer & whatever is going on in it, then the editor itself
+  struct editorConfig *selected = codible_editor;
+  codibleSelect(editor);
+  editorGrepStop();
+  editorFindStop();
+  editorCloseFile();
+  if (E.index) {
+    editorIndexToggle();
+  }
+  codibleSelect(selected == editor ? NULL : selected);
+  free(editor);
+}
+
+void codibleSelect(struct editorConfig *editor) {
+  // the editor the functions of this thread work on from now on
+  codible_editor = editor;
+}
+
+void editorHookRefresh() {
+  if (E.refresh) {
+    E.refresh();
+  }
+}
+
+void editorHookIdle() {
+  if (E.idle) {
+    E.idle();
+  }
+}
+
+/* A thorough knowledge of VARIADIC FUNCTION is needed !!!
+   the ... denotes the function can take any number of arguments
+*/
+void editorSetStatusMessage (const char *fmt, ...) {
+  /* there will be va_start() to denote the start 
+     of the operation and va_end() to denote the end
+     of the operation of a value type va_list.
+  */
+  va_list ap;
+  /* the last argument before the ... must be passed
+     to va_start() to get the address of the next argument.
+     Between va_start() and va_end(), there will be va_arg()
+     which will be executed on the type of the next argument.
+  */
+  va_start(ap, fmt);
+  /* storing the resulting string in E.statusmessage 
+     Here, vsnprintf() works as a va_arg();
+  */
+  vsnprintf(E.statusmessage, sizeof(E.statusmessage), fmt, ap);
+  va_end(ap);
+  // setting the current time in status message time
+  E.statusmessage_time = time(NULL);
+  /* current time can be gotten by passing NULL inside the time()
+     it will calculate the seconds have past since 
+     January 1, 1970 midnight.
+  */
+}
+
+/*** unicode ***/
+
+/* code points drawn on top of the character before them (combining
+   marks) or not drawn at all (zero width spaces, joiners, format
+   characters). sorted, so they can be binary searched
+*/
+const editorRange zero_width_ranges[] = {
+  {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, 
+  {0x05BF, 0x05BF}, {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, 
+  {0x05C7, 0x05C7}, {0x0600, 0x0605}, {0x0610, 0x061A}, 
+  {0x061C, 0x061C}, {0x064B, 0x065F}, {0x0670, 0x0670}, 
+  {0x06D6, 0x06DD}, {0x06DF, 0x06E4}, {0x06E7, 0x06E8}, 
+  {0x06EA, 0x06ED}, {0x070F, 0x070F}, {0x0711, 0x0711}, 
+  {0x0730, 0x074A}, {0x07A6, 0x07B0}, {0x07EB, 0x07F3}, 
+  {0x0816, 0x0819}, {0x081B, 0x0823}, {0x0825, 0x0827}, 
+  {0x0829, 0x082D}, {0x0859, 0x085B}, {0x08D3, 0x0902}, 
+  {0x093A, 0x093A}, {0x093C, 0x093C}, {0x0941, 0x0948}, 
+  {0x094D, 0x094D}, {0x0951, 0x0957}, {0x0962, 0x0963}, 
+  {0x0981, 0x0981}, {0x09BC, 0x09BC}, {0x09C1, 0x09C4}, 
+  {0x09CD, 0x09CD}, {0x09E2, 0x09E3}, {0x0A01, 0x0A02}, 
+  {0x0A3C, 0x0A3C}, {0x0A41, 0x0A51}, {0x0A70, 0x0A71}, 
+  {0x0A75, 0x0A75}, {0x0A81, 0x0A82}, {0x0ABC, 0x0ABC}, 
+  {0x0AC1, 0x0AC8}, {0x0ACD, 0x0ACD}, {0x0AE2, 0x0AE3}, 
+  {0x0B01, 0x0B01}, {0x0B3C, 0x0B3C}, {0x0B3F, 0x0B3F}, 
+  {0x0B41, 0x0B44}, {0x0B4D, 0x0B4D}, {0x0B56, 0x0B56}, 
+  {0x0B62, 0x0B63}, {0x0B82, 0x0B82}, {0x0BC0, 0x0BC0}, 
+  {0x0BCD, 0x0BCD}, {0x0C00, 0x0C00}, {0x0C3E, 0x0C40}, 
+  {0x0C46, 0x0C56}, {0x0C62, 0x0C63}, {0x0CBC, 0x0CBC}, 
+  {0x0CCC, 0x0CCD}, {0x0CE2, 0x0CE3}, {0x0D41, 0x0D44}, 
+  {0x0D4D, 0x0D4D}, {0x0D62, 0x0D63}, {0x0DCA, 0x0DCA}, 
+  {0x0DD2, 0x0DD6}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, 
+  {0x0E47, 0x0E4E}, {0x0EB1, 0x0EB1}, {0x0EB4, 0x0EBC}, 
+  {0x0EC8, 0x0ECD}, {0x0F18, 0x0F19}, {0x0F35, 0x0F35}, 
+  {0x0F37, 0x0F37}, {0x0F39, 0x0F39}, {0x0F71, 0x0F7E}, 
+  {0x0F80, 0x0F84}, {0x0F86, 0x0F87}, {0x0F8D, 0x0FBC}, 
+  {0x0FC6, 0x0FC6}, {0x102D, 0x1030}, {0x1032, 0x1037}, 
+  {0x1039, 0x103A}, {0x103D, 0x103E}, {0x1058, 0x1059}, 
+  {0x105E, 0x1060}, {0x1071, 0x1074}, {0x1082, 0x1082}, 
+  {0x1085, 0x1086}, {0x108D, 0x108D}, {0x109D, 0x109D}, 
+  {0x1160, 0x11FF}, {0x135D, 0x135F}, {0x1712, 0x1714}, 
+  {0x1732, 0x1734}, {0x1752, 0x1753}, {0x1772, 0x1773}, 
+  {0x17B4, 0x17B5}, {0x17B7, 0x17BD}, {0x17C6, 0x17C6}, 
+  {0x17C9, 0x17D3}, {0x17DD, 0x17DD}, {0x180B, 0x180E}, 
+  {0x18A9, 0x18A9}, {0x1920, 0x1922}, {0x1927, 0x1928}, 
+  {0x1932, 0x1932}, {0x1939, 0x193B}, {0x1A17, 0x1A18}, 
+  {0x1A56, 0x1A56}, {0x1A58, 0x1A60}, {0x1A62, 0x1A62}, 
+  {0x1A65, 0x1A6C}, {0x1A73, 0x1A7F}, {0x1AB0, 0x1AFF}, 
+  {0x1B00, 0x1B03}, {0x1B34, 0x1B34}, {0x1B36, 0x1B3A}, 
+  {0x1B3C, 0x1B3C}, {0x1B42, 0x1B42}, {0x1B6B, 0x1B73}, 
+  {0x1B80, 0x1B81}, {0x1BA2, 0x1BA5}, {0x1BA8, 0x1BA9}, 
+  {0x1C2C, 0x1C33}, {0x1C36, 0x1C37}, {0x1CD0, 0x1CD2}, 
+  {0x1CD4, 0x1CE0}, {0x1CE2, 0x1CE8}, {0x1DC0, 0x1DFF}, 
+  {0x200B, 0x200F}, {0x202A, 0x202E}, {0x2060, 0x2064}, 
+  {0x206A, 0x206F}, {0x20D0, 0x20F0}, {0x2CEF, 0x2CF1}, 
+  {0x2D7F, 0x2D7F}, {0x2DE0, 0x2DFF}, {0x302A, 0x302D}, 
+  {0x3099, 0x309A}, {0xA66F, 0xA672}, {0xA674, 0xA67D}, 
+  {0xA69E, 0xA69F}, {0xA6F0, 0xA6F1}, {0xA802, 0xA802}, 
+  {0xA806, 0xA806}, {0xA80B, 0xA80B}, {0xA825, 0xA826}, 
+  {0xA8C4, 0xA8C5}, {0xA8E0, 0xA8F1}, {0xA926, 0xA92D}, 
+  {0xA947, 0xA951}, {0xA980, 0xA982}, {0xA9B3, 0xA9B3}, 
+  {0xA9B6, 0xA9B9}, {0xA9BC, 0xA9BD}, {0xAA29, 0xAA2E}, 
+  {0xAA31, 0xAA32}, {0xAA35, 0xAA36}, {0xAA43, 0xAA43}, 
+  {0xAA4C, 0xAA4C}, {0xAAB0, 0xAAB0}, {0xAAB2, 0xAAB4}, 
+  {0xAAB7, 0xAAB8}, {0xAABE, 0xAABF}, {0xAAC1, 0xAAC1}, 
+  {0xABE5, 0xABE5}, {0xABE8, 0xABE8}, {0xABED, 0xABED}, 
+  {0xD7B0, 0xD7FF}, {0xFB1E, 0xFB1E}, {0xFE00, 0xFE0F}, 
+  {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF}, {0xFFF9, 0xFFFB}, 
+  {0x101FD, 0x101FD}, {0x10A01, 0x10A0F}, {0x10A38, 0x10A3F}, 
+  {0x11001, 0x11001}, {0x11038, 0x11046}, {0x1107F, 0x11081}, 
+  {0x110B3, 0x110B6}, {0x110B9, 0x110BA}, {0x1D167, 0x1D169}, 
+  {0x1D173, 0x1D182}, {0x1D185, 0x1D18B}, {0x1D1AA, 0x1D1AD}, 
+  {0x1D242, 0x1D244}, {0x1F3FB, 0x1F3FF}, {0xE0001, 0xE007F}, 
+  {0xE0100, 0xE01EF}
+};
+
+/* code points of East Asian wide & fullwidth characters and of the
+   emoji that terminals draw two columns wide. sorted as well
+*/
+const editorRange double_width_ranges[] = {
+  {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, 
+  {0x23E9, 0x23EC}, {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, 
+  {0x25FD, 0x25FE}, {0x2614, 0x2615}, {0x2648, 0x2653}, 
+  {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1}, 
+  {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5}, 
+  {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, 
+  {0x26F2, 0x26F3}, {0x26F5, 0x26F5}, {0x26FA, 0x26FA}, 
+  {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, 
+  {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, 
+  {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797}, 
+  {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, 
+  {0x2B50, 0x2B50}, {0x2B55, 0x2B55}, {0x2E80, 0x303E}, 
+  {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, 
+  {0xA000, 0xA4CF}, {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, 
+  {0xF900, 0xFAFF}, {0xFE10, 0xFE19}, {0xFE30, 0xFE6F}, 
+  {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4}, 
+  {0x17000, 0x18CFF}, {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004}, 
+  {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, 
+  {0x1F200, 0x1F202}, {0x1F210, 0x1F23B}, {0x1F240, 0x1F248}, 
+  {0x1F250, 0x1F251}, {0x1F260, 0x1F265}, {0x1F300, 0x1F320}, 
+  {0x1F32D, 0x1F335}, {0x1F337, 0x1F37C}, {0x1F37E, 0x1F393}, 
+  {0x1F3A0, 0x1F3CA}, {0x1F3CF, 0x1F3D3}, {0x1F3E0, 0x1F3F0}, 
+  {0x1F3F4, 0x1F3F4}, {0x1F3F8, 0x1F43E}, {0x1F440, 0x1F440}, 
+  {0x1F442, 0x1F4FC}, {0x1F4FF, 0x1F53D}, {0x1F54B, 0x1F54E}, 
+  {0x1F550, 0x1F567}, {0x1F57A, 0x1F57A}, {0x1F595, 0x1F596}, 
+  {0x1F5A4, 0x1F5A4}, {0x1F5FB, 0x1F64F}, {0x1F680, 0x1F6C5}, 
+  {0x1F6CC, 0x1F6CC}, {0x1F6D0, 0x1F6D2}, {0x1F6D5, 0x1F6D7}, 
+  {0x1F6EB, 0x1F6EC}, {0x1F6F4, 0x1F6FC}, {0x1F7E0, 0x1F7EB}, 
+  {0x1F90C, 0x1F93A}, {0x1F93C, 0x1F945}, {0x1F947, 0x1F9FF}, 
+  {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD}
+};
+
+#define RANGE_ENTRIES(r) ((int)(sizeof(r) / sizeof(r[0])))
+
+int editorInRanges(int cp, const editorRange *ranges, int count) {
+  int low = 0, high = count - 1;
+  while (low <= high) {
+    int mid = low + (high - low)/2;
+    if (cp < ranges[mid].first) {
+      high = mid - 1;
+    }
+    else if (cp > ranges[mid].last) {
+      low = mid + 1;
+    }
+    else {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int editorCharWidth(int cp) {
+  /* columns a code point takes on the screen. control characters
+     & invalid bytes (cp -1) are drawn as one inverted symbol
+  */
+  if (cp < 0x300) {
+    return 1;
+  }
+  if (editorInRanges(cp, zero_width_ranges, 
+    RANGE_ENTRIES(zero_width_ranges))) {
+    return 0;
+  }
+  if (editorInRanges(cp, double_width_ranges, 
+    RANGE_ENTRIES(double_width_ranges))) {
+    return 2;
+  }
+  return 1;
+}
+
+int editorUtf8Decode(const char *s, ptrdiff_t len, int *cp) {
+  /* decoding the UTF-8 sequence at the start of s, which has len
+     bytes left. returns the number of bytes it takes. a byte that
+     doesn't start a valid sequence (a stray continuation byte, an
+     overlong form, a surrogate, a cut off sequence) stands on its
+     own & *cp is set to -1
+  */
+  const unsigned char *u = (const unsigned char *)s;
+  *cp = -1;
+  if (u[0] < 0x80) {
+    *cp = u[0];
+    return 1;
+  }
+  int n, value, min;
+  if (u[0] >= 0xC2 && u[0] <= 0xDF) {
+    n = 2; 
+    value = u[0] & 0x1F; 
+    min = 0x80;
+  }
+  else if (u[0] >= 0xE0 && u[0] <= 0xEF) {
+    n = 3; 
+    value = u[0] & 0x0F; 
+    min = 0x800;
+  }
+  else if (u[0] >= 0xF0 && u[0] <= 0xF4) {
+    n = 4; 
+    value = u[0] & 0x07; 
+    min = 0x10000;
+  }
+  else {
+    return 1;
+  }
+  if (n > len) {
+    return 1;
+  }
+  for (int k=1; k<n; k++) {
+    if ((u[k] & 0xC0) != 0x80) {
+      return 1;
+    }
+    value = (value << 6) | (u[k] & 0x3F);
+  }
+  if (value < min || value > 0x10FFFF || 
+    (value >= 0xD800 && value <= 0xDFFF)) {
+    return 1;
+  }
+  *cp = value;
+  return n;
+}
+
+int editorIsAscii(const char *s, ptrdiff_t len) {
+  /* checking whether no byte has its high bit set, 16 bytes at a 
+     time where SSE2 is there
+  */
+  ptrdiff_t j = 0;
+
+#ifdef __SSE2__
+  __m128i bits = _mm_setzero_si128();
+  for (; j + 16 <= len; j += 16) {
+    bits = _mm_or_si128(bits, _mm_loadu_si128((const __m128i *)&s[j]));
+  }
+  if (_mm_movemask_epi8(bits)) {
+    return 0;
+  }
+#endif
+  for (; j < len; j++) {
+    if ((unsigned char)s[j] & 0x80) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*** syntax files ***/
+
+int editorTrieNode(editorTrie *trie, int parent, int byte) {
+  if (trie->nodes == trie->cap) {
+    trie->cap = trie->cap ? 2*trie->cap : 64;
+    trie->child = editorReallocArray(trie->child, trie->cap, 
+      sizeof(*trie->child));
+    trie->accept = editorReallocArray(trie->accept, trie->cap, 
+      sizeof(int));
+    trie->parent = editorReallocArray(trie->parent, trie->cap, 
+      sizeof(int));
+    trie->byte = editorReallocArray(trie->byte, trie->cap, 1);
+  }
+  memset(trie->child[trie->nodes], 0, sizeof(*trie->child));
+  trie->accept[trie->nodes] = -1;
+  trie->parent[trie->nodes] = parent;
+  trie->byte[trie->nodes] = byte;
+  return trie->nodes++;
+}
+
+void editorTrieAdd(editorTrie *trie, const char *word, int accept) {
+  int node = 0;
+  for (const unsigned char *p = (const unsigned char *)word; *p; p++) {
+    if (trie->child[node][*p] == 0) {
+      int child = editorTrieNode(trie, node, *p);
+      trie->child[node][*p] = child;
+    }
+    node = trie->child[node][*p];
+  }
+  trie->accept[node] = accept;
+}
+
+void editorTrieFree(editorTrie *trie) {
+  free(trie->child);
+  free(trie->accept);
+  free(trie->parent);
+  free(trie->byte);
+}
+
+int editorLexMatch(const char *delimiter, int matched, int c) {
+  /* how much of the delimiter the text ends with after c, when it
+     ended with matched bytes of it before c
+  */
+  for (int j = matched + 1; j > 0; j--) {
+    if ((unsigned char)delimiter[j-1] == c && 
+      memcmp(delimiter, delimiter + matched - (j-1), j-1) == 0) {
+      return j;
+    }
+  }
+  return 0;
+}
+
+editorLexConfig editorLexTarget(editorSyntaxSource *src, int node) {
+  // what a delimiter opens, right after it
+  int accept = src->openers.accept[node];
+  editorLexConfig target = {accept >> 8, 0};
+  if (target.mode == LEX_STRING) {
+    target.node = accept & 0xff;
+  }
+  else if (target.mode == LEX_BLOCK) {
+    target.node = (accept & 0xff)*CODIBLE_LEX_DELIMITER;
+  }
+  return target;
+}
+
+editorLexConfig editorLexOpened(editorSyntaxSource *src, int node) {
+  /* a delimiter that no longer one goes on from opens at once, the
+     others wait for the bytes after them
+  */
+  if (src->openers.accept[node] >= 0) {
+    int c = 0;
+    while (c < 256 && src->openers.child[node][c] == 0) {
+      c++;
+    }
+    if (c == 256) {
+      return editorLexTarget(src, node);
+    }
+  }
+  return (editorLexConfig){LEX_OPENER, node};
+}
+
+editorLexConfig editorLexStart(editorSyntaxSource *src, int c, 
+  int separated) {
+  // a token starting with c, separated if a separator comes before it
+  if (src->openers.child[0][c]) {
+    return editorLexOpened(src, src->openers.child[0][c]);
+  }
+  if (src->numbers && isdigit(c) && separated) {
+    return (editorLexConfig){LEX_NUMBER, 0};
+  }
+  if (separated && src->keywords.child[0][c]) {
+    return (editorLexConfig){LEX_KEYWORD, src->keywords.child[0][c]};
+  }
+  return (editorLexConfig){src->separators[c] ? LEX_BASE : LEX_WORD, 0};
+}
+
+editorLexConfig editorLexStep(editorSyntaxSource *src, 
+  editorLexConfig from, int c, int *end) {
+  /* where the lexer goes on byte c. *end gets the highlight of the
+     token c ends, or -1 if it doesn't end one
+  */
+  editorLexConfig to = from;
+  int opener = (src->openers.child[0][c] != 0);
+  *end = -1;
+  switch (from.mode) {
+    case LEX_BASE:
+    case LEX_WORD:
+      // plain text runs on as one token
+      to = editorLexStart(src, c, from.mode == LEX_BASE);
+      if (to.mode != LEX_BASE && to.mode != LEX_WORD) {
+        *end = HL_NORMAL;
+      }
+      break;
+
+    case LEX_KEYWORD:
+      if (!opener && !src->separators[c]) {
+        int child = src->keywords.child[from.node][c];
+        to = (editorLexConfig){child ? LEX_KEYWORD : LEX_WORD, child};
+        break;
+      }
+      // a keyword only if a separator ends it
+      *end = (src->keywords.accept[from.node] >= 0 && 
+        src->separators[c]) ? src->keywords.accept[from.node] : HL_NORMAL;
+      to = editorLexStart(src, c, 0);
+      break;
+
+    case LEX_NUMBER:
+      if (!opener && (isdigit(c) || c == '.')) {
+        break;
+      }
+      *end = HL_NUMBER;
+      to = editorLexStart(src, c, 0);
+      break;
+
+    case LEX_STRING:
+      if (c == '\\') {
+        to.mode = LEX_ESCAPE;
+      }
+      else if (c == from.node) {
+        to = (editorLexConfig){LEX_STRING_END, 0};
+      }
+      break;
+
+    case LEX_ESCAPE:
+      to.mode = LEX_STRING;
+      break;
+
+    case LEX_STRING_END:
+      *end = HL_STRING;
+      to = editorLexStart(src, c, 1);
+      break;
+
+    case LEX_COMMENT:
+      break;
+
+    case LEX_BLOCK: {
+      int block = from.node/CODIBLE_LEX_DELIMITER;
+      char *delimiter = src->blocks[block].end;
+      int matched = editorLexMatch(delimiter, 
+        from.node % CODIBLE_LEX_DELIMITER, c);
+      to.node = block*CODIBLE_LEX_DELIMITER + matched;
+      if (delimiter[matched] == '\0') {
+        to = (editorLexConfig){LEX_BLOCK_END, block};
+      }
+      break;
+    }
+
+    case LEX_BLOCK_END:
+      *end = src->blocks[from.node].highlight;
+      to = editorLexStart(src, c, 1);
+      break;
+
+    case LEX_OPENER: {
+      int child = src->openers.child[from.node][c];
+      if (child) {
+        return editorLexOpened(src, child);
+      }
+      /* the longest delimiter among the bytes waiting opens, or the 
+         first of them is plain text. the bytes after it get lexed
+         again, a token they end is taken to end at c
+      */
+      unsigned char path[CODIBLE_LEX_DELIMITER];
+      int nodes[CODIBLE_LEX_DELIMITER];
+      int depth = 0;
+      for (int node = from.node; node != 0; 
+        node = src->openers.parent[node]) {
+        path[depth] = src->openers.byte[node];
+        nodes[depth++] = node;
+      }
+      int k = 0;
+      while (k < depth && src->openers.accept[nodes[k]] < 0) {
+        k++;
+      }
+      if (k < depth) {
+        to = editorLexTarget(src, nodes[k]);
+      }
+      else {
+        k = depth - 1;
+        to.mode = src->separators[path[k]] ? LEX_BASE : LEX_WORD;
+      }
+      int ended;
+      for (k--; k >= 0; k--) {
+        to = editorLexStep(src, to, path[k], &ended);
+        *end = (ended >= 0) ? ended : *end;
+      }
+      to = editorLexStep(src, to, c, &ended);
+      *end = (ended >= 0) ? ended : *end;
+      return to;
+    }
+  }
+  return to;
+}
+
+editorLexConfig editorLexEol(editorSyntaxSource *src, 
+  editorLexConfig from, int *end) {
+  /* the end of a row, *end gets the highlight of the token it ends
+     & only a multi line block goes on in the next row
+  */
+  editorLexConfig base = {LEX_BASE, 0};
+  switch (from.mode) {
+    case LEX_KEYWORD:
+      *end = (src->keywords.accept[from.node] >= 0) ? 
+        src->keywords.accept[from.node] : HL_NORMAL;
+      return base;
+    case LEX_NUMBER:
+      *end = HL_NUMBER;
+      return base;
+    case LEX_STRING:
+    case LEX_ESCAPE:
+    case LEX_STRING_END:
+      *end = HL_STRING;
+      return base;
+    case LEX_COMMENT:
+      *end = HL_COMMENT;
+      return base;
+    case LEX_BLOCK: {
+      int block = from.node/CODIBLE_LEX_DELIMITER;
+      *end = src->blocks[block].highlight;
+      return (editorLexConfig){LEX_BLOCK, block*CODIBLE_LEX_DELIMITER};
+    }
+    case LEX_BLOCK_END:
+      *end = src->blocks[from.node].highlight;
+      return base;
+    case LEX_OPENER:
+      if (src->openers.accept[from.node] >= 0) {
+        return editorLexEol(src, editorLexTarget(src, from.node), end);
+      }
+      break;
+  }
+  *end = HL_NORMAL;
+  return base;
+}
+
+int editorLexState(struct editorSyntax *syntax, editorLexConfig config,
+  editorLexConfig **configs, int *ids, int span) {
+  /* the state of a config, a new one if it has none yet. returns -1
+     when there would be more than CODIBLE_LEX_STATES
+  */
+  int *id = &ids[config.mode*span + config.node];
+  if (*id >= 0) {
+    return *id;
+  }
+  if (syntax->states == CODIBLE_LEX_STATES) {
+    return -1;
+  }
+  int state = syntax->states++;
+  if ((state & (state - 1)) == 0) {
+    // growing the tables whenever the states reach a power of 2
+    int cap = state ? 2*state : 1;
+    *configs = editorReallocArray(*configs, cap, sizeof(editorLexConfig));
+    syntax->next = editorReallocArray(syntax->next, (ptrdiff_t)cap*256, 
+      sizeof(uint16_t));
+    syntax->eolhighlight = editorReallocArray(syntax->eolhighlight, cap,
+      1);
+    syntax->eolnext = editorReallocArray(syntax->eolnext, cap, 
+      sizeof(uint16_t));
+  }
+  (*configs)[state] = config;
+  *id = state;
+  return state;
+}
+
+int editorSyntaxCompile(editorSyntaxSource *src, 
+  struct editorSyntax *syntax) {
+  /* building the lexer's tables from every state reachable from the
+     start of a row. state 0 is that start. returns -1 if there are 
+     too many states
+  */
+  int span = CODIBLE_LEX_BLOCKS*CODIBLE_LEX_DELIMITER;
+  span = (src->keywords.nodes > span) ? src->keywords.nodes : span;
+  span = (src->openers.nodes > span) ? src->openers.nodes : span;
+  int *ids = editorMallocArray((ptrdiff_t)LEX_MODES*span, sizeof(int));
+  memset(ids, 0xff, (size_t)LEX_MODES*span*sizeof(int));
+  editorLexConfig *configs = NULL;
+  int failed = 0;
+  editorLexState(syntax, (editorLexConfig){LEX_BASE, 0}, &configs, ids, 
+    span);
+  for (int state = 0; state < syntax->states && !failed; state++) {
+    for (int c = 0; c < 256; c++) {
+      int end;
+      editorLexConfig to = editorLexStep(src, configs[state], c, &end);
+      int next = editorLexState(syntax, to, &configs, ids, span);
+      if (next == -1) {
+        failed = 1;
+        break;
+      }
+      syntax->next[state << 8 | c] = next | ((end + 1) << 12);
+    }
+    int end;
+    editorLexConfig to = editorLexEol(src, configs[state], &end);
+    int next = editorLexState(syntax, to, &configs, ids, span);
+    failed |= (next == -1);
+    syntax->eolhighlight[state] = end;
+    syntax->eolnext[state] = (next == -1) ? 0 : next;
+  }
+  free(configs);
+  free(ids);
+  return failed ? -1 : 0;
+}
+
+void editorSyntaxFree(struct editorSyntax *syntax) {
+  free(syntax->filetype);
+  for (int j = 0; syntax->filematch && syntax->filematch[j]; j++) {
+    free(syntax->filematch[j]);
+  }
+  free(syntax->filematch);
+  free(syntax->next);
+  free(syntax->eolhighlight);
+  free(syntax->eolnext);
+}
+
+int editorSyntaxDelimiter(const char *delimiter, const char **error) {
+  if (delimiter == NULL || *delimiter == '\0') {
+    *error = "a delimiter is missing";
+    return -1;
+  }
+  if (strlen(delimiter) >= CODIBLE_LEX_DELIMITER) {
+    *error = "a delimiter is too long";
+    return -1;
+  }
+  return 0;
+}
+
+int editorSyntaxParse(FILE *fp, struct editorSyntax *syntax, 
+  const char **error, int *lineno) {
+  /* reading a syntax file & compiling it into syntax. a line is a 
+     directive & its words, # starts a comment line:
+       filetype NAME
+       files .EXT NAME ...      extensions & parts of file names
+       comment START            to the end of the row
+       multiline START END      a comment over several rows
+       multistring START END    a string over several rows
+       strings QUOTE ...        single character quotes, \ escapes
+       numbers
+       separators CHARS         where keywords & numbers can start,
+                                besides white space
+       keywords WORD ...
+       types WORD ...           the second color of keywords
+     returns -1 with the error & its line if it can't
+  */
+  editorSyntaxSource src;
+  memset(&src, 0, sizeof(src));
+  editorTrieNode(&src.keywords, 0, 0);
+  editorTrieNode(&src.openers, 0, 0);
+  char *separators = strdup(",.()+-/*=~%<>[];");
+  int files = 0;
+  char *line = NULL;
+  size_t linecap = 0;
+  *error = NULL;
+  *lineno = 0;
+  while (*error == NULL && getline(&line, &linecap, fp) != -1) {
+    (*lineno)++;
+    char *directive = strtok(line, " \t\r\n");
+    if (directive == NULL || directive[0] == '#') {
+      continue;
+    }
+    char *word = strtok(NULL, " \t\r\n");
+    if (strcmp(directive, "filetype") == 0 && word) {
+      free(syntax->filetype);
+      syntax->filetype = strdup(word);
+    }
+    else if (strcmp(directive, "files") == 0) {
+      for (; word; word = strtok(NULL, " \t\r\n")) {
+        syntax->filematch = editorReallocArray(syntax->filematch, 
+          files + 2, sizeof(char *));
+        syntax->filematch[files++] = strdup(word);
+        syntax->filematch[files] = NULL;
+      }
+    }
+    else if (strcmp(directive, "comment") == 0) {
+      if (editorSyntaxDelimiter(word, error) == 0) {
+        editorTrieAdd(&src.openers, word, LEX_COMMENT << 8);
+      }
+    }
+    else if (strcmp(directive, "multiline") == 0 || 
+      strcmp(directive, "multistring") == 0) {
+      char *end = strtok(NULL, " \t\r\n");
+      if (src.blockcount == CODIBLE_LEX_BLOCKS) {
+        *error = "too many multi line comments & strings";
+      }
+      else if (editorSyntaxDelimiter(word, error) == 0 && 
+        editorSyntaxDelimiter(end, error) == 0) {
+        editorTrieAdd(&src.openers, word, LEX_BLOCK << 8 | src.blockcount);
+        editorLexBlock *block = &src.blocks[src.blockcount++];
+        block->end = strdup(end);
+        block->highlight = (directive[5] == 'l') ? HL_MLCOMMENT : 
+          HL_STRING;
+      }
+    }
+    else if (strcmp(directive, "strings") == 0) {
+      for (; word && *error == NULL; word = strtok(NULL, " \t\r\n")) {
+        if (strlen(word) != 1) {
+          *error = "a quote is one character";
+        }
+        else {
+          editorTrieAdd(&src.openers, word, 
+            LEX_STRING << 8 | (unsigned char)word[0]);
+        }
+      }
+    }
+    else if (strcmp(directive, "numbers") == 0) {
+      src.numbers = 1;
+    }
+    else if (strcmp(directive, "separators") == 0 && word) {
+      free(separators);
+      separators = strdup(word);
+    }
+    else if (strcmp(directive, "keywords") == 0 || 
+      strcmp(directive, "types") == 0) {
+      int highlight = (directive[0] == 'k') ? HL_KEYWORD1 : HL_KEYWORD2;
+      for (; word; word = strtok(NULL, " \t\r\n")) {
+        editorTrieAdd(&src.keywords, word, highlight);
+      }
+    }
+    else {
+      *error = "unknown directive";
+    }
+  }
+  free(line);
+  if (*error == NULL && syntax->filetype == NULL) {
+    *error = "no filetype";
+  }
+  if (*error == NULL && syntax->filematch == NULL) {
+    *error = "no files";
+  }
+  for (int c = 0; c < 256; c++) {
+    src.separators[c] = (isspace(c) || c == '\0' || 
+      strchr(separators, c) != NULL);
+  }
+  if (*error == NULL && editorSyntaxCompile(&src, syntax) == -1) {
+    *error = "too many keywords & delimiters";
+  }
+  free(separators);
+  for (int j = 0; j < src.blockcount; j++) {
+    free(src.blocks[j].end);
+  }
+  editorTrieFree(&src.keywords);
+  editorTrieFree(&src.openers);
+  return (*error == NULL) ? 0 : -1;
+}
+
+void editorSyntaxRead(FILE *fp, const char *name) {
+  // adding a syntax file to HLDB, in place of one of its filetype
+  struct editorSyntax syntax;
+  memset(&syntax, 0, sizeof(syntax));
+  const char *error;
+  int lineno;
+  if (editorSyntaxParse(fp, &syntax, &error, &lineno) == -1) {
+    editorSetStatusMessage("%.30s, line %d: %s", name, lineno, error);
+    editorSyntaxFree(&syntax);
+    return;
+  }
+  int j = 0;
+  while (j < hldb_entries && strcmp(HLDB[j].filetype, syntax.filetype)) {
+    j++;
+  }
+  if (j == hldb_entries) {
+    HLDB = editorReallocArray(HLDB, ++hldb_entries, 
+      sizeof(struct editorSyntax));
+  }
+  else {
+    editorSyntaxFree(&HLDB[j]);
+  }
+  HLDB[j] = syntax;
+}
+
+int editorSyntaxFileFilter(const struct dirent *entry) {
+  size_t len = strlen(entry->d_name);
+  return len > 7 && strcmp(entry->d_name + len - 7, ".syntax") == 0;
+}
+
+void editorSyntaxLoadFiles() {
+  /* the built in C & then the files ending in .syntax in the 
+     directory $CODIBLE_SYNTAX, ~/.codible/syntax without it. adding
+     a language only takes a file there
+  */
+  FILE *fp = fmemopen(C_HL_syntax, strlen(C_HL_syntax), "r");
+  if (fp) {
+    editorSyntaxRead(fp, "C");
+    fclose(fp);
+  }
+  char dir[PATH_MAX];
+  const char *home = getenv("HOME");
+  if (getenv("CODIBLE_SYNTAX")) {
+    snprintf(dir, sizeof(dir), "%s", getenv("CODIBLE_SYNTAX"));
+  }
+  else if (home) {
+    snprintf(dir, sizeof(dir), "%s/.codible/syntax", home);
+  }
+  else {
+    return;
+  }
+  struct dirent **entries;
+  int count = scandir(dir, &entries, editorSyntaxFileFilter, alphasort);
+  for (int j = 0; j < count; j++) {
+    char path[PATH_MAX];
+    int len = snprintf(path, sizeof(path), "%s/%s", dir, entries[j]->d_name);
+    fp = (len < (int)sizeof(path)) ? fopen(path, "r") : NULL;
+    if (fp) {
+      editorSyntaxRead(fp, entries[j]->d_name);
+      fclose(fp);
+    }
+    free(entries[j]);
+  }
+  if (count >= 0) {
+    free(entries);
+  }
+}
+
+void editorSyntaxLoad() {
+  // filling HLDB once, whichever thread gets here first
+  pthread_once(&hldb_once, editorSyntaxLoadFiles);
+}
+
+/*** syntax highlighting ***/
+
+int editorRowStartState(erow *row) {
+  /* a row starts where the previous one left the lexer, which is 
+     the start state unless a multi line comment or string is open
+  */
+  int state = (row->index > 0) ? E.row[row->index - 1].hl_state : 0;
+  // a state left over from another syntax
+  return (state < E.syntax->states) ? state : 0;
+}
+
+void editorHighlightSet(unsigned char *hl, ptrdiff_t hlfrom, 
+  ptrdiff_t hlto, ptrdiff_t at, int highlight, ptrdiff_t len) {
+  // only the part of [at, at+len) that lies in [hlfrom, hlto) is kept
+  if (hl == NULL) {
+    return;
+  }
+  ptrdiff_t end = at + len;
+  if (at < hlfrom) {
+    at = hlfrom;
+  }
+  if (end > hlto) {
+    end = hlto;
+  }
+  if (at < end) {
+    memset(&hl[at - hlfrom], highlight, end - at);
+  }
+}
+
+void editorHighlightChars(erow *row, ptrdiff_t from, ptrdiff_t to, 
+  int *state, unsigned char *hl, ptrdiff_t hlfrom) {
+  /* highlighting the chars of a row from position "from" in the
+     given lexer state until it reaches "to", a table lookup a byte.
+     hl[j - hlfrom] gets the highlight of chars[j] for hlfrom <= j <
+     to, it has to be HL_NORMAL to begin with. hl can be NULL when 
+     only the state is wanted. a token still open at "to" gets the
+     highlight it would have if the row ended there
+  */
+  const uint16_t *next = E.syntax->next;
+  const unsigned char *chars = (const unsigned char *)row->chars;
+  int s = *state;
+  if (hl == NULL) {
+    for (ptrdiff_t i = from; i < to; i++) {
+      s = LEX_STATE(next[s << 8 | chars[i]]);
+    }
+    *state = s;
+    return;
+  }
+  ptrdiff_t token = from;
+  for (ptrdiff_t i = from; i < to; i++) {
+    unsigned int t = next[s << 8 | chars[i]];
+    if (LEX_TOKEN(t)) {
+      // every byte of the token that ends gets its highlight
+      if (LEX_TOKEN(t) - 1 != HL_NORMAL) {
+        editorHighlightSet(hl, hlfrom, to, token, LEX_TOKEN(t) - 1, 
+          i - token);
+      }
+      token = i;
+    }
+    s = LEX_STATE(t);
+  }
+  editorHighlightSet(hl, hlfrom, to, token, E.syntax->eolhighlight[s], 
+    to - token);
+  *state = s;
+}
+
+void editorExpandHighlight(erow *row, unsigned char *hl, ptrdiff_t cstart, 
+  ptrdiff_t cend) {
+  /* hl[0 .. cend-cstart) holds one highlight per byte of 
+     chars[cstart .. cend). spreading them over the render bytes of
+     those chars, where a tab takes up to CODIBLE_TAB_STOP of them.
+     the bytes of a multibyte character are copied as they are, so
+     only tabs move things. moving from the last tab backwards never
+     overwrites an unmoved entry
+  */
+  ptrdiff_t rbase = editorRowCxToRb(row, cstart);
+  ptrdiff_t j = cend;
+  for (ptrdiff_t k = editorRowSpansBefore(row, cend) - 1; 
+    k >= 0 && row->spans[k].cx >= cstart; k--) {
+    ptrdiff_t cx = row->spans[k].cx;
+    if (row->chars[cx] != '\t') {
+      continue;
+    }
+    ptrdiff_t start = editorRowCxToRb(row, cx) - rbase;
+    ptrdiff_t after = row->spans[k].rb - rbase;
+    memmove(&hl[after], &hl[cx + 1 - cstart], j - cx - 1);
+    memset(&hl[start], hl[cx - cstart], after - start);
+    j = cx;
+  }
+}
+
+void editorSetStale(erow *row, int stale) {
+  if (row->hl_stale == stale) {
+    return;
+  }
+  row->hl_stale = stale;
+  E.hlstalecount += stale ? 1 : -1;
+  if (stale && row->index < E.hlstale) {
+    E.hlstale = row->index;
+  }
+}
+
+void editorSetEndState(erow *row, int state) {
+  int changed = (row->hl_state != state);
+  /* Setting the state the row ends in, the row got highlighted from
+     the one before it. the next row has to be highlighted again 
+     when a comment or string it's in changed, which waits for the
+     idle time or for the row to be drawn. an edit that opens a 
+     comment doesn't highlight the rest of the file then & there
+  */
+  row->hl_state = state;
+  editorSetStale(row, 0);
+  if (changed && row->index + 1 < E.numrows) {
+    editorSetStale(&E.row[row->index + 1], 1);
+  }
+}
+
+int editorHighlightStale(ptrdiff_t upto, long long deadline) {
+  /* highlighting the stale rows before row upto in order, until 
+     none is left or editorMicroseconds() reaches the deadline. 
+     returns whether there were any
+  */
+  if (E.hlstalecount == 0 || E.hlstale >= upto || E.hlstale >= E.numrows) {
+    return 0;
+  }
+  do {
+    if (E.row[E.hlstale].hl_stale) {
+      editorUpdateSyntax(&E.row[E.hlstale]);
+    }
+    E.hlstale++;
+  } while (E.hlstalecount && E.hlstale < upto && E.hlstale < E.numrows &&
+    editorMicroseconds() < deadline);
+  return 1;
+}
+
+int editorHighlightIdle(long long deadline) {
+  return editorHighlightStale(E.numrows, deadline);
+}
+
+int editorRowRelex(erow *row, ptrdiff_t at) {
+  /* rebuilding the lexer checkpoints of a long row. the ones that 
+     an edit at "at" can't reach are kept, the lexer restarts from 
+     the last of them. the remaining old checkpoints lie after the 
+     edit, as soon as the lexer reaches one of them in the very
+     same state everything after it is still valid & lexing stops.
+     returns the state the next row starts in
+  */
+  int state = E.syntax ? editorRowStartState(row) : 0;
+  erowCheckpoint *old = row->checkpoints;
+  ptrdiff_t oldcount = row->checkpointcount;
+  ptrdiff_t keep = 0;
+  /* nothing can be kept if the row doesn't start in the state
+     its checkpoints were built from. the state before chars[cx] 
+     only depends on the chars before it
+  */
+  if (oldcount && old[0].state == state) {
+    while (keep < oldcount && old[keep].cx <= at) {
+      keep++;
+    }
+  }
+  ptrdiff_t capacity = keep + 16;
+  erowCheckpoint *checkpoints = editorMallocArray(capacity, 
+    sizeof(erowCheckpoint));
+  if (keep) {
+    memcpy(checkpoints, old, sizeof(erowCheckpoint)*keep);
+  }
+  ptrdiff_t count = keep;
+  ptrdiff_t pos = 0;
+  if (keep) {
+    pos = checkpoints[keep-1].cx;
+    state = checkpoints[keep-1].state;
+  }
+  else {
+    checkpoints[count].cx = 0;
+    checkpoints[count++].state = state;
+  }
+  ptrdiff_t t = keep;
+  int converged = 0;
+  while (E.syntax && pos < row->size) {
+    while (t < oldcount && old[t].cx <= pos) {
+      t++;
+    }
+    // stopping at the next old checkpoint to compare the states
+    ptrdiff_t target = pos + CODIBLE_HL_CHECKPOINT;
+    if (t < oldcount && old[t].cx < target) {
+      target = old[t].cx;
+    }
+    if (target > row->size) {
+      target = row->size;
+    }
+    editorHighlightChars(row, pos, target, &state, NULL, 0);
+    pos = target;
+    if (pos >= row->size) {
+      break;
+    }
+    if (t < oldcount && old[t].cx == pos && old[t].state == state) {
+      converged = 1;
+    }
+    ptrdiff_t needed = count + (converged ? oldcount - t : 1);
+    if (needed > capacity) {
+      capacity = needed*2;
+      checkpoints = editorReallocArray(checkpoints, capacity, 
+        sizeof(erowCheckpoint));
+    }
+    if (converged) {
+      memcpy(&checkpoints[count], &old[t], 
+        sizeof(erowCheckpoint)*(oldcount - t));
+      count += oldcount - t;
+      break;
+    }
+    checkpoints[count].cx = pos;
+    checkpoints[count++].state = state;
+  }
+  editorRowFree(MEMORY_CHECKPOINTS, old);
+  row->checkpoints = checkpoints;
+  editorMemoryAdd(MEMORY_CHECKPOINTS, checkpoints);
+  row->checkpointcount = count;
+  if (E.syntax == NULL) {
+    return 0;
+  }
+  return converged ? row->hl_state : E.syntax->eolnext[state];
+}
+
+void editorRowShiftCheckpoints(erow *row, ptrdiff_t at, ptrdiff_t removed, 
+  ptrdiff_t inserted) {
+  /* dropping the checkpoints of a long row that the edit touched 
+     and moving the ones after it along with their characters
+  */
+  ptrdiff_t count = 0;
+  for (ptrdiff_t k=0; k<row->checkpointcount; k++) {
+    erowCheckpoint checkpoint = row->checkpoints[k];
+    if (checkpoint.cx >= at + removed) {
+      checkpoint.cx += inserted - removed;
+    }
+    else if (checkpoint.cx > at) {
+      continue;
+    }
+    row->checkpoints[count++] = checkpoint;
+  }
+  row->checkpointcount = count;
+}
+
+void editorUpdateSyntax(erow *row) {
+  PROFILE_BEGIN(PHASE_HIGHLIGHT);
+  if (row->size >= CODIBLE_LONG_LINE) {
+    /* a long row only keeps its checkpoints up to date, its window
+       gets highlighted again when it is drawn
+    */
+    editorRowFree(MEMORY_RENDER, row->render);
+    row->render = NULL;
+    row->rsize = 0;
+    editorSetEndState(row, editorRowRelex(row, 0));
+    PROFILE_END(PHASE_HIGHLIGHT);
+    return;
+  }
+  if (row->render == NULL) {
+    /* a row dropped by editorDropRenders() only keeps the state it
+       ends in, it gets highlighted when it's rendered again
+    */
+    if (E.syntax != NULL) {
+      int state = editorRowStartState(row);
+      editorHighlightChars(row, 0, row->size, &state, NULL, 0);
+      editorSetEndState(row, E.syntax->eolnext[state]);
+    }
+    PROFILE_END(PHASE_HIGHLIGHT);
+    return;
+  }
+  row->highlight = editorRowRealloc(MEMORY_HIGHLIGHT, row->highlight, 
+    row->rsize, 1);
+  memset(row->highlight, HL_NORMAL, row->rsize);
+  if (E.syntax != NULL) {
+    int state = editorRowStartState(row);
+    editorHighlightChars(row, 0, row->size, &state, row->highlight, 0);
+    editorExpandHighlight(row, row->highlight, 0, row->size);
+    editorSetEndState(row, E.syntax->eolnext[state]);
+  }
+  PROFILE_END(PHASE_HIGHLIGHT);
+}
+
+void editorRowRenderWindow(erow *row, ptrdiff_t col, int width) {
+  /* rendering & highlighting only the columns around [col, col+width)
+     of a long row. nothing happens while the current window still
+     covers them
+  */
+  if (row->render && col >= editorRowCxToRx(row, row->cwin) && 
+    (col + width <= editorRowCxToRx(row, row->cwinend) || 
+      row->cwinend == row->size)) {
+    return;
+  }
+  PROFILE_BEGIN(PHASE_HIGHLIGHT);
+  ptrdiff_t startcol = col - CODIBLE_LONG_LINE_MARGIN;
+  if (startcol < 0) {
+    startcol = 0;
+  }
+  ptrdiff_t cstart = editorRowRxToCx(row, startcol);
+  ptrdiff_t endcol = col + width + CODIBLE_LONG_LINE_MARGIN;
+  ptrdiff_t cend = editorRowRxToCx(row, endcol);
+  if (cend < row->size && editorRowCxToRx(row, cend) < endcol) {
+    // including a character that is only partly inside the window
+    cend = editorRowNextChar(row, cend);
+  }
+  row->cwin = cstart;
+  row->cwinend = cend;
+  row->rsize = editorRowCxToRb(row, cend) - editorRowCxToRb(row, cstart);
+  editorRowFree(MEMORY_RENDER, row->render);
+  row->render = editorRowRealloc(MEMORY_RENDER, NULL, row->rsize + 1, 1);
+  editorRenderChars(row, cstart, cend, row->render);
+  row->render[row->rsize] = '\0';
+  row->highlight = editorRowRealloc(MEMORY_HIGHLIGHT, row->highlight, 
+    row->rsize + 1, 1);
+
+  memset(row->highlight, HL_NORMAL, row->rsize + 1);
+  if (E.syntax == NULL) {
+    PROFILE_END(PHASE_HIGHLIGHT);
+    return;
+  }
+  // starting from the last checkpoint before the window
+  ptrdiff_t low = 0, high = row->checkpointcount;
+  while (high - low > 1) {
+    ptrdiff_t mid = low + (high - low)/2;
+    if (row->checkpoints[mid].cx <= cstart) {
+      low = mid;
+    }
+    else {
+      high = mid;
+    }
+  }
+  int state = row->checkpoints[low].state;
+  editorHighlightChars(row, row->checkpoints[low].cx, cend, &state, 
+    row->highlight, cstart);
+  editorExpandHighlight(row, row->highlight, cstart, cend);
+  PROFILE_END(PHASE_HIGHLIGHT);
+}
+
+int editorLexRow(erow *row, int state) {
+  /* highlighting a row from scratch in the given start state, 
+     touching nothing but the row, so that the highlight workers can
+     do it. a short row's highlight already has its rsize bytes. a 
+     long row gets checkpoints that E.memory doesn't count yet, in 
+     place of uncounted ones or none. returns the state the next row
+     starts in
+  */
+  if (row->size >= CODIBLE_LONG_LINE) {
+    ptrdiff_t count = (row->size - 1)/CODIBLE_HL_CHECKPOINT + 1;
+    free(row->checkpoints);
+    row->checkpoints = editorMallocArray(count, sizeof(erowCheckpoint));
+    for (ptrdiff_t k=0; k<count; k++) {
+      ptrdiff_t cx = k*CODIBLE_HL_CHECKPOINT;
+      row->checkpoints[k].cx = cx;
+      row->checkpoints[k].state = state;
+      ptrdiff_t end = cx + CODIBLE_HL_CHECKPOINT;
+      editorHighlightChars(row, cx, (end < row->size) ? end : row->size, 
+        &state, NULL, 0);
+    }
+    row->checkpointcount = count;
+  }
+  else if (row->render == NULL) {
+    // dropped, see editorUpdateSyntax()
+    editorHighlightChars(row, 0, row->size, &state, NULL, 0);
+  }
+  else {
+    memset(row->highlight, HL_NORMAL, row->rsize);
+    editorHighlightChars(row, 0, row->size, &state, row->highlight, 0);
+    editorExpandHighlight(row, row->highlight, 0, row->size);
+  }
+  return E.syntax->eolnext[state];
+}
+
+void *editorHighlightWorker(void *arg) {
+  editorHighlightJob *job = arg;
+  codibleSelect(job->editor);
+  ptrdiff_t chunk;
+  while ((chunk = atomic_fetch_add(&job->nextchunk, 1)) < job->chunkcount) {
+    // guessing that no multi line comment or string is open
+    int state = 0;
+    for (ptrdiff_t j=job->chunks[chunk]; j<job->chunks[chunk+1]; j++) {
+      state = editorLexRow(&E.row[j], state);
+      E.row[j].hl_state = state;
+    }
+  }
+  return NULL;
+}
+
+void editorHighlightRows() {
+  /* highlighting every row, after a file got opened or its syntax
+     changed. a big file gets cut into chunks that threads highlight
+     at once. going through the chunks in order afterwards, one that
+     doesn't start in the state its guess had is highlighted again 
+     until a row ends in the state it ended in before
+  */
+  ptrdiff_t bytes = 0;
+  for (ptrdiff_t j=0; j<E.numrows; j++) {
+    bytes += E.row[j].size;
+  }
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  // $CODIBLE_HL_THREADS in place of the processors, for the tests
+  if (getenv("CODIBLE_HL_THREADS")) {
+    threads = atol(getenv("CODIBLE_HL_THREADS"));
+  }
+  if (threads > CODIBLE_HL_THREADS) {
+    threads = CODIBLE_HL_THREADS;
+  }
+  if (E.syntax == NULL || bytes < CODIBLE_HL_PARALLEL || threads < 2) {
+    for (ptrdiff_t j=0; j<E.numrows; j++) {
+      // checkpoints of long rows belong to the previous syntax
+      E.row[j].checkpointcount = 0;
+      editorUpdateSyntax(&E.row[j]);
+    }
+    return;
+  }
+  PROFILE_BEGIN(PHASE_HIGHLIGHT);
+  E.hlstalecount = 0;
+  for (ptrdiff_t j=0; j<E.numrows; j++) {
+    erow *row = &E.row[j];
+    row->hl_stale = 0;
+    if (row->size >= CODIBLE_LONG_LINE) {
+      // drawing renders its window again
+      editorRowFree(MEMORY_RENDER, row->render);
+      row->render = NULL;
+      row->rsize = 0;
+      editorRowFree(MEMORY_CHECKPOINTS, row->checkpoints);
+      row->checkpoints = NULL;
+      row->checkpointcount = 0;
+    }
+  }
+  // a few chunks a thread, so that a slow one doesn't hold up the rest
+  editorHighlightJob job = {.editor = codible_editor};
+  job.chunks = editorMallocArray(threads*4 + 1, sizeof(ptrdiff_t));
+  job.chunks[0] = 0;
+  ptrdiff_t sum = 0;
+  for (ptrdiff_t j=0; j<E.numrows; j++) {
+    sum += E.row[j].size;
+    if (sum >= (bytes/(threads*4))*(job.chunkcount + 1) && 
+      job.chunkcount < threads*4 - 1) {
+      job.chunks[++job.chunkcount] = j + 1;
+    }
+  }
+  job.chunks[++job.chunkcount] = E.numrows;
+  atomic_init(&job.nextchunk, 0);
+  // resize signals are for the editor, not for the workers
+  sigset_t blocked, previous;
+  sigemptyset(&blocked);
+  sigaddset(&blocked, SIGWINCH);
+  pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+  pthread_t workers[CODIBLE_HL_THREADS];
+  int started = 0;
+  for (int i=1; i<threads; i++) {
+    if (pthread_create(&workers[started], NULL, editorHighlightWorker, 
+      &job) == 0) {
+      started++;
+    }
+  }
+  pthread_sigmask(SIG_SETMASK, &previous, NULL);
+  editorHighlightWorker(&job);
+  for (int i=0; i<started; i++) {
+    pthread_join(workers[i], NULL);
+  }
+  for (ptrdiff_t k=1; k<job.chunkcount; k++) {
+    int state = E.row[job.chunks[k] - 1].hl_state;
+    if (state == 0) {
+      // the guess was right
+      continue;
+    }
+    for (ptrdiff_t j=job.chunks[k]; j<E.numrows; j++) {
+      int guessed = E.row[j].hl_state;
+      state = editorLexRow(&E.row[j], state);
+      E.row[j].hl_state = state;
+      if (state == guessed) {
+        break;
+      }
+    }
+  }
+  free(job.chunks);
+  for (ptrdiff_t j=0; j<E.numrows; j++) {
+    if (E.row[j].size >= CODIBLE_LONG_LINE) {
+      editorMemoryAdd(MEMORY_CHECKPOINTS, E.row[j].checkpoints);
+    }
+  }
+  PROFILE_END(PHASE_HIGHLIGHT);
+}
+
+void editorSelectSyntaxHighlight() {
+  E.syntax = NULL;
+  if (E.filename == NULL) {
+    return;
+  }
+  /* strrchr() returns a pointer to the last occurance of
+     a character in a string
+  */
+  char *ext = strrchr(E.filename, '.');
+  editorSyntaxLoad();
+  // the syntax files read last take precedence
+  for (int j = hldb_entries - 1; j >= 0; j--) {
+    struct editorSyntax *s = &HLDB[j];
+    unsigned int i = 0;
+    while(s->filematch[i]) {
+      int is_ext = (s->filematch[i][0] == '.');
+      if ((is_ext && ext && !strcmp(ext, s->filematch[i])) || 
+            (!is_ext && strstr(E.filename, s->filematch[i]))) {
+        E.syntax = s;
+        editorHighlightRows();
+        return;
+      }
+      i++;
+    }
+  }
+}
+
+/*** row operations ***/
+
+ptrdiff_t editorRowSpansBefore(erow *row, ptrdiff_t cx) {
+  /* binary search for the number of spans starting to the left
+     of cx in chars
+  */
+  ptrdiff_t low = 0, high = row->spancount;
+  while (low < high) {
+    ptrdiff_t mid = low + (high - low)/2;
+    if (row->spans[mid].cx < cx) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+ptrdiff_t editorRowCxToRx (erow *row, ptrdiff_t cx) {
+  ptrdiff_t k = editorRowSpansBefore(row, cx);
+  if (k == 0) {
+    // nothing to the left but characters one column wide
+    return cx;
+  }
+  /* starting from the column right after the nearest span to the
+     left, the remaining characters take one column each
+  */
+  erowSpan *span = &row->spans[k-1];
+  ptrdiff_t after = span->cx + span->len;
+  return span->rx + (cx > after ? cx - after : 0);
+}
+
+ptrdiff_t editorRowCxToRb(erow *row, ptrdiff_t cx) {
+  // the same as editorRowCxToRx(), for bytes of render
+  ptrdiff_t k = editorRowSpansBefore(row, cx);
+  if (k == 0) {
+    return cx;
+  }
+  erowSpan *span = &row->spans[k-1];
+  ptrdiff_t after = span->cx + span->len;
+  return span->rb + (cx > after ? cx - after : 0);
+}
+
+ptrdiff_t editorRowRxToCx(erow *row, ptrdiff_t rx) {
+  // binary search for the number of spans drawn before rx
+  ptrdiff_t low = 0, high = row->spancount;
+  while (low < high) {
+    ptrdiff_t mid = low + (high - low)/2;
+    if (row->spans[mid].rx <= rx) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  ptrdiff_t cx = rx;
+  if (low > 0) {
+    erowSpan *span = &row->spans[low-1];
+    cx = span->cx + span->len + (rx - span->rx);
+  }
+  /* if rx falls inside the columns of the next span (a tab or a
+     wide character), the cursor belongs on that span
+  */
+  if (low < row->spancount && cx > row->spans[low].cx) {
+    cx = row->spans[low].cx;
+  }
+  if (cx > row->size) {
+    cx = row->size;
+  }
+  return cx;
+}
+
+ptrdiff_t editorRowNextChar(erow *row, ptrdiff_t cx) {
+  /* position of the character after the one at cx. combining marks
+     go along with the character they are drawn on
+  */
+  if (cx >= row->size) {
+    return row->size;
+  }
+  ptrdiff_t k = editorRowSpansBefore(row, cx);
+  if (k < row->spancount && row->spans[k].cx == cx) {
+    cx += row->spans[k++].len;
+  }
+  else {
+    cx++;
+  }
+  while (k < row->spancount && row->spans[k].cx == cx && 
+    row->spans[k].width == 0 && row->chars[cx] != '\t') {
+    cx += row->spans[k++].len;
+  }
+  return cx;
+}
+
+ptrdiff_t editorRowPrevChar(erow *row, ptrdiff_t cx) {
+  // position of the character before cx, skipping combining marks
+  ptrdiff_t k = editorRowSpansBefore(row, cx);
+  while (cx > 0) {
+    int combining = 0;
+    if (k > 0 && row->spans[k-1].cx + row->spans[k-1].len == cx) {
+      cx = row->spans[--k].cx;
+      combining = (row->spans[k].width == 0 && row->chars[cx] != '\t');
+    }
+    else {
+      cx--;
+    }
+    if (!combining) {
+      break;
+    }
+  }
+  return cx;
+}
+
+ptrdiff_t editorRowCharStart(erow *row, ptrdiff_t cx) {
+  /* start of the character that cx points into, for a cursor that
+     kept its cx while moving to another row
+  */
+  if (cx >= row->size) {
+    return row->size;
+  }
+  ptrdiff_t k = editorRowSpansBefore(row, cx);
+  if (k > 0 && row->spans[k-1].cx + row->spans[k-1].len > cx) {
+    cx = row->spans[k-1].cx;
+  }
+  return editorRowPrevChar(row, editorRowNextChar(row, cx));
+}
+
+void editorAppendSpan(erowSpan **spans, ptrdiff_t *count, ptrdiff_t cx, 
+  int len, int width) {
+  // growing the array whenever its size reaches a power of 2
+  if ((*count & (*count - 1)) == 0) {
+    *spans = editorReallocArray(*spans, *count ? *count*2 : 1, 
+      sizeof(erowSpan));
+  }
+  erowSpan *span = &(*spans)[(*count)++];
+  span->cx = cx;
+  span->len = len;
+  span->width = width;
+}
+
+ptrdiff_t editorRowScanSpans(erow *row, ptrdiff_t from, ptrdiff_t to, 
+  erowSpan **spans, ptrdiff_t *count) {
+  /* appending the spans of the characters in chars[from .. to), 
+     their rb & rx are left for editorRowLayoutSpans(). from has to
+     be a character boundary. returns where the scan stopped, past
+     "to" when the last character crosses it
+  */
+  ptrdiff_t j = from;
+  while (j < to) {
+    unsigned char c = row->chars[j];
+    if (c == '\t') {
+      editorAppendSpan(spans, count, j, 1, 0);
+      j++;
+    }
+    else if (c < 0x80) {
+      j++;
+    }
+    else {
+      int cp;
+      int len = editorUtf8Decode(&row->chars[j], row->size - j, &cp);
+      if (len > 1) {
+        editorAppendSpan(spans, count, j, len, editorCharWidth(cp));
+      }
+      j += len;
+    }
+  }
+  return j;
+}
+
+void editorRowLayoutSpans(erow *row, ptrdiff_t first) {
+  /* computing rb & rx of spans[first ..] from the span before them.
+     a tab reaches the next tab stop, a multibyte character copies
+     its bytes to render
+  */
+  ptrdiff_t cx = 0, rb = 0, rx = 0;
+  if (first > 0) {
+    erowSpan *prev = &row->spans[first-1];
+    cx = prev->cx + prev->len;
+    rb = prev->rb;
+    rx = prev->rx;
+  }
+  for (ptrdiff_t k=first; k<row->spancount; k++) {
+    erowSpan *span = &row->spans[k];
+    rb += span->cx - cx;
+    rx += span->cx - cx;
+    if (row->chars[span->cx] == '\t') {
+      ptrdiff_t spaces = CODIBLE_TAB_STOP - rx%CODIBLE_TAB_STOP;
+      rb += spaces;
+      rx += spaces;
+    }
+    else {
+      rb += span->len;
+      rx += span->width;
+    }
+    span->rb = rb;
+    span->rx = rx;
+    cx = span->cx + span->len;
+  }
+}
+
+void editorRenderChars(erow *row, ptrdiff_t cstart, ptrdiff_t cend, 
+  char *render) {
+  /* writing what chars[cstart .. cend) look like in render. a tab
+     becomes spaces up to the next tab stop, the rest is copied
+  */
+  ptrdiff_t j = cstart;
+  ptrdiff_t index = 0;
+  for (ptrdiff_t k = editorRowSpansBefore(row, cstart); 
+    k < row->spancount && row->spans[k].cx < cend; k++) {
+    erowSpan *span = &row->spans[k];
+    memcpy(&render[index], &row->chars[j], span->cx - j);
+    index += span->cx - j;
+    if (row->chars[span->cx] == '\t') {
+      ptrdiff_t spaces = span->rb - editorRowCxToRb(row, span->cx);
+      memset(&render[index], ' ', spaces);
+      index += spaces;
+    }
+    else {
+      memcpy(&render[index], &row->chars[span->cx], span->len);
+      index += span->len;
+    }
+    j = span->cx + span->len;
+  }
+  memcpy(&render[index], &row->chars[j], cend - j);
+}
+
+void editorUpdateRow(erow *row) {
+  editorIndexUpdateRow(row);
+  editorRowFree(MEMORY_SPANS, row->spans);
+  row->spans = NULL;
+  row->spancount = 0;
+  if (editorIsAscii(row->chars, row->size)) {
+    // plain ASCII, so only the tabs need a span
+    char *tab = memchr(row->chars, '\t', row->size);
+    while (tab) {
+      editorAppendSpan(&row->spans, &row->spancount, 
+        tab - row->chars, 1, 0);
+      tab = memchr(tab + 1, '\t', row->chars + row->size - tab - 1);
+    }
+  }
+  else {
+    editorRowScanSpans(row, 0, row->size, &row->spans, &row->spancount);
+  }
+  editorMemoryAdd(MEMORY_SPANS, row->spans);
+  editorRowLayoutSpans(row, 0);
+  if (row->size >= CODIBLE_LONG_LINE) {
+    /* a long row is never rendered as a whole, only its span index
+       & lexer checkpoints are built here
+    */
+    row->checkpointcount = 0;
+    editorUpdateSyntax(row);
+    return;
+  }
+  editorRowFree(MEMORY_CHECKPOINTS, row->checkpoints);
+  row->checkpoints = NULL;
+  row->checkpointcount = 0;
+  row->wrapwidth = 0;
+  editorRowRender(row);
+}
+
+void editorRowRender(erow *row) {
+  // rendering & highlighting a short row as a whole
+  row->cwin = 0;
+  row->cwinend = row->size;
+  editorRowFree(MEMORY_RENDER, row->render);
+  row->rsize = editorRowCxToRb(row, row->size);
+  row->render = editorRowRealloc(MEMORY_RENDER, NULL, row->rsize + 1, 1);
+  editorRenderChars(row, 0, row->size, row->render);
+  row->render[row->rsize] = '\0';
+  editorUpdateSyntax(row);
+}
+
+void editorRowPatchSpans(erow *row, ptrdiff_t at, ptrdiff_t removed, 
+  ptrdiff_t inserted) {
+  /* updating the span index after "removed" bytes at "at" got
+     replaced by "inserted" ones, without rescanning the row. the
+     edit can complete a UTF-8 sequence whose first bytes were left
+     invalid before it, so scanning starts back at those bytes
+  */
+  ptrdiff_t first = editorRowSpansBefore(row, at);
+  ptrdiff_t from = at;
+  if (first > 0 && row->spans[first-1].cx + row->spans[first-1].len > at) {
+    // the edit cut into a multibyte character
+    from = row->spans[--first].cx;
+  }
+  else {
+    while (from > 0 && from > at - 3 && 
+      (unsigned char)row->chars[from-1] >= 0x80 && (first == 0 || 
+        row->spans[first-1].cx + row->spans[first-1].len < from)) {
+      from--;
+    }
+  }
+  ptrdiff_t tail = editorRowSpansBefore(row, at + removed);
+  erowSpan *added = NULL;
+  ptrdiff_t addedcount = 0;
+  editorRowScanSpans(row, from, at + inserted, &added, &addedcount);
+  ptrdiff_t count = row->spancount - (tail - first) + addedcount;
+  if (count > row->spancount) {
+    row->spans = editorRowRealloc(MEMORY_SPANS, row->spans, count, 
+      sizeof(erowSpan));
+  }
+  memmove(&row->spans[first + addedcount], &row->spans[tail], 
+    sizeof(erowSpan)*(row->spancount - tail));
+  if (addedcount) {
+    memcpy(&row->spans[first], added, sizeof(erowSpan)*addedcount);
+  }
+  free(added);
+  row->spancount = count;
+  /* laying out the spans from the edit onwards. as soon as an old 
+     span still ends on the same column (a tab absorbed the change),
+     the columns of all the spans after it are still right & their
+     bytes only moved by the same amount
+  */
+  ptrdiff_t cx = 0, rb = 0, rx = 0;
+  if (first > 0) {
+    erowSpan *prev = &row->spans[first-1];
+    cx = prev->cx + prev->len;
+    rb = prev->rb;
+    rx = prev->rx;
+  }
+  for (ptrdiff_t k=first; k<count; k++) {
+    erowSpan *span = &row->spans[k];
+    int old = (k >= first + addedcount);
+    if (old) {
+      span->cx += inserted - removed;
+    }
+    rb += span->cx - cx;
+    rx += span->cx - cx;
+    if (row->chars[span->cx] == '\t') {
+      ptrdiff_t spaces = CODIBLE_TAB_STOP - rx%CODIBLE_TAB_STOP;
+      rb += spaces;
+      rx += spaces;
+    }
+    else {
+      rb += span->len;
+      rx += span->width;
+    }
+    if (old && span->rx == rx) {
+      ptrdiff_t shift = rb - span->rb;
+      span->rb = rb;
+      for (k++; k<count; k++) {
+        row->spans[k].cx += inserted - removed;
+        row->spans[k].rb += shift;
+      }
+      break;
+    }
+    span->rb = rb;
+    span->rx = rx;
+    cx = span->cx + span->len;
+  }
+}
+
+void editorRowChanged(erow *row, ptrdiff_t at, ptrdiff_t removed, 
+  ptrdiff_t inserted) {
+  /* "removed" characters at "at" got replaced by "inserted" ones.
+     a short row is cheap to rebuild completely. a long row that 
+     stays long only patches what the edit could have touched
+  */
+  if (row->size < CODIBLE_LONG_LINE || row->checkpointcount == 0) {
+    editorUpdateRow(row);
+    return;
+  }
+  editorRowPatchSpans(row, at, removed, inserted);
+  editorRowShiftCheckpoints(row, at, removed, inserted);
+  editorRowFree(MEMORY_RENDER, row->render);
+  row->render = NULL;
+  row->rsize = 0;
+  editorSetEndState(row, editorRowRelex(row, at));
+}
+
+void editorInsertRow (ptrdiff_t at, char *s, size_t len) {
+  if (at<0 || at>E.numrows || len >= PTRDIFF_MAX) {
+    // validating the index
+    return;
+  }
+  E.row = editorRowRealloc(MEMORY_ROWS, E.row, E.numrows + 1, 
+    sizeof(erow));
+  memmove(&E.row[at+1], &E.row[at], sizeof(erow)*(E.numrows-at));
+  for (ptrdiff_t j=at+1; j<=E.numrows; j++) {
+    /* updating index of the row because of the insertion
+       of the new row
+    */
+    E.row[j].index++;
+  }
+  E.row[at].index = at;
+  E.row[at].size = len;
+  E.row[at].chars = editorRowRealloc(MEMORY_CHARS, NULL, len + 1, 1);
+  memcpy(E.row[at].chars, s, len);
+  E.row[at].chars[len] = '\0';
+  /* Initializing the rendering size is 0 
+     and the rendering string is NULL
+  */
+  E.row[at].rsize = 0;
+  E.row[at].render = NULL;
+  E.row[at].highlight = NULL;
+  /* the row after the new one used to follow the previous row,
+     starting from its state lets the highlighter notice when
+     that row has to be highlighted again
+  */
+  E.row[at].hl_state = (at > 0) ? E.row[at-1].hl_state : 0;
+  E.row[at].hl_stale = 0;
+  E.row[at].spans = NULL;
+  E.row[at].spancount = 0;
+  E.row[at].cwin = 0;
+  E.row[at].cwinend = 0;
+  E.row[at].checkpoints = NULL;
+  E.row[at].checkpointcount = 0;
+  E.row[at].wraps = NULL;
+  E.row[at].wrapcount = 0;
+  E.row[at].wrapwidth = 0;
+  E.row[at].id = -1;
+  E.numrows++;
+  editorIndexMoveRows(at, 1, -1);
+  editorUpdateRow(&E.row[at]);
+  E.dirty++;
+}
+
+void editorFreeRow(erow *row) {
+  editorRowFree(MEMORY_RENDER, row->render);
+  editorRowFree(MEMORY_CHARS, row->chars);
+  editorRowFree(MEMORY_HIGHLIGHT, row->highlight);
+  editorRowFree(MEMORY_SPANS, row->spans);
+  editorRowFree(MEMORY_CHECKPOINTS, row->checkpoints);
+  editorRowFree(MEMORY_WRAPS, row->wraps);
+}
+
+void editorDelRow(ptrdiff_t at) {
+  if (at<0 || at>=E.numrows) {
+    return;
+  }
+  int state = E.row[at].hl_state;
+  int id = E.row[at].id;
+  editorSetStale(&E.row[at], 0);
+  if (E.hlstale > at) {
+    // the rows after it move up
+    E.hlstale = at;
+  }
+  editorFreeRow(&E.row[at]);
+  memmove(&E.row[at], &E.row[at+1], sizeof(erow)*(E.numrows-at-1));
+  for (ptrdiff_t j=at; j<E.numrows-1; j++) {
+    /* Updating index of the row because of the deletion
+       of an existing row
+    */
+    E.row[j].index--;
+  }
+  E.numrows--;
+  editorIndexMoveRows(at, 0, id);
+  E.dirty++;
+  /* the row after the deleted one now follows the previous row,
+     which might leave it in a different lexer state
+  */
+  int prev_state = (at > 0) ? E.row[at-1].hl_state : 0;
+  if (at < E.numrows && state != prev_state) {
+    editorUpdateSyntax(&E.row[at]);
+  }
+}
+
+void editorRowInsertChar(erow *row, ptrdiff_t at, int c) {
+  if (at<0 || at>row->size) {
+    at = row->size;
+  }
+  row->chars = editorRowRealloc(MEMORY_CHARS, row->chars, row->size + 2, 1);
+  /* memmove is safe to use than memcpy when source & 
+     destination of an array overlaps with each other 
+  */
+  memmove(&row->chars[at+1], &row->chars[at], row->size - at+1);
+  row->size++;
+  row->chars[at] = c;
+  // updating render & rsize
+  editorRowChanged(row, at, 0, 1);
+  E.dirty++;
+}
+
+void editorRowInsertString(erow *row, ptrdiff_t at, const char *s, 
+  size_t len) {
+  // editorRowInsertChar() for a run of characters at once
+  if (at<0 || at>row->size) {
+    at = row->size;
+  }
+  if (len > (size_t)(PTRDIFF_MAX - row->size - 1)) {
+    errno = ENOMEM;
+    die("realloc");
+  }
+  row->chars = editorRowRealloc(MEMORY_CHARS, row->chars, 
+    row->size + len + 1, 1);
+  memmove(&row->chars[at+len], &row->chars[at], row->size - at+1);
+  memcpy(&row->chars[at], s, len);
+  row->size += len;
+  editorRowChanged(row, at, 0, len);
+  E.dirty++;
+}
+
+void editorRowAppendString(erow *row, char *s, size_t len) {
+  if (len > (size_t)(PTRDIFF_MAX - row->size - 1)) {
+    errno = ENOMEM;
+    die("realloc");
+  }
+  row->chars = editorRowRealloc(MEMORY_CHARS, row->chars, 
+    row->size + len + 1, 1);
+  // appending the string in the row
+  memcpy(&row->chars[row->size], s, len);
+  // updating the size
+  row->size += len;
+  row->chars[row->size] = '\0';
+  editorRowChanged(row, row->size - len, 0, len);
+  E.dirty++;
+}
+
+void editorRowDelChar(erow *row, ptrdiff_t at) {
+  if (at < 0 || at >= row->size) {
+    return;
+  }
+  /* a character can take several bytes, along with the combining 
+     marks drawn on it
+  */
+  ptrdiff_t len = editorRowNextChar(row, at) - at;
+  // overwrite the deleted character with the next characters
+  memmove(&row->chars[at], &row->chars[at+len], row->size - at - len + 1);
+  // then decrement the size of the row
+  row->size -= len;
+  editorRowChanged(row, at, len, 0);
+  E.dirty++;
+}
+
+int editorWrapWidth() {
+  return E.screencolumns > 0 ? E.screencolumns : 1;
+}
+
+void editorRowUpdateWraps(erow *row) {
+  /* finding where the row gets wrapped, right after the last space
+     that still fits on the screen or before the first character
+     that doesn't if there is none. a row filling its last visual 
+     line completely gets an empty one more, so the cursor can sit 
+     after its last character
+  */
+  int width = editorWrapWidth();
+  if (row->wrapwidth == width) {
+    return;
+  }
+  row->wrapcount = 0;
+  ptrdiff_t start = 0, space = 0, col = 0, cx = 0, k = 0;
+  while (1) {
+    int span = (k < row->spancount && row->spans[k].cx == cx);
+    int len = span ? row->spans[k].len : 1;
+    ptrdiff_t w = span ? row->spans[k].rx - col : 1;
+    if (cx < row->size && (col + w <= start + width || col == start)) {
+      // the character still fits on the current visual line
+      if ((row->chars[cx] == ' ' || row->chars[cx] == '\t') && 
+        col > start) {
+        space = col + w;
+      }
+      col += w;
+      cx += len;
+      k += span;
+      continue;
+    }
+    if (cx >= row->size && col - start < width) {
+      break;
+    }
+    ptrdiff_t wrapat = (space > start) ? space : col;
+    // growing the array whenever its size reaches a power of 2
+    if ((row->wrapcount & (row->wrapcount - 1)) == 0) {
+      row->wraps = editorRowRealloc(MEMORY_WRAPS, row->wraps, 
+        row->wrapcount ? row->wrapcount*2 : 1, sizeof(ptrdiff_t));
+    }
+    row->wraps[row->wrapcount++] = wrapat;
+    start = wrapat;
+  }
+  row->wrapwidth = width;
+}
+
+ptrdiff_t editorRowVisualLines(erow *row) {
+  if (row->checkpointcount) {
+    /* a long row is wrapped at the screen edge, so nothing needs to
+       be computed for it
+    */
+    return editorRowCxToRx(row, row->size)/editorWrapWidth() + 1;
+  }
+  editorRowUpdateWraps(row);
+  return row->wrapcount + 1;
+}
+
+ptrdiff_t editorRowWrapStart(erow *row, ptrdiff_t line) {
+  // screen column where a visual line of the row starts
+  if (line == 0) {
+    return 0;
+  }
+  if (row->checkpointcount) {
+    return line*editorWrapWidth();
+  }
+  editorRowUpdateWraps(row);
+  return row->wraps[line-1];
+}
+
+ptrdiff_t editorRowVisualLine(erow *row, ptrdiff_t rx) {
+  // visual line of the row that shows the screen column rx
+  if (row->checkpointcount) {
+    return rx/editorWrapWidth();
+  }
+  editorRowUpdateWraps(row);
+  ptrdiff_t low = 0, high = row->wrapcount;
+  while (low < high) {
+    ptrdiff_t mid = low + (high - low)/2;
+    if (row->wraps[mid] <= rx) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+int editorWrapStep(ptrdiff_t *filerow, ptrdiff_t *line, int direction) {
+  /* moving a (row, visual line) position by one visual line. 
+     the position after the last row is where the cursor goes 
+     past the end of the file. returns 0 if it can't move
+  */
+  if (direction > 0) {
+    if (*filerow >= E.numrows) {
+      return 0;
+    }
+    if (*line + 1 < editorRowVisualLines(&E.row[*filerow])) {
+      (*line)++;
+    }
+    else {
+      (*filerow)++;
+      *line = 0;
+    }
+  }
+  else {
+    if (*line > 0) {
+      (*line)--;
+    }
+    else if (*filerow > 0) {
+      (*filerow)--;
+      *line = editorRowVisualLines(&E.row[*filerow]) - 1;
+    }
+    else {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*** editor operations ***/
+
+void editorInsertChar (int c) {
+  if (E.cy == E.numrows) {
+    /* appending a blank row after the end of a line to take 
+       the character from the user
+    */
+    editorInsertRow(E.numrows,"", 0);
+  }
+  editorRowInsertChar(&E.row[E.cy], E.cx, c);
+  /* after taking the character, moving forward the cursor
+     to take the next character right after the previous one
+  */
+  E.cx++;
+}
+
+void editorInsertNewLine() {
+  if (E.cx == 0) {
+    /* if the cursor at the beginning of a line, then 
+       pressing Enter will create a blank line before
+       that line
+    */
+    editorInsertRow(E.cy, "", 0);
+  }
+  else {
+    erow *row = &E.row[E.cy];
+    /* passing the characters of the right of cursor
+       to the new line
+    */
+    editorInsertRow(E.cy+1, &row->chars[E.cx], row->size - E.cx);
+    row = &E.row[E.cy];
+    ptrdiff_t removed = row->size - E.cx;
+    row->size = E.cx;
+    row->chars[row->size] = '\0';
+    editorRowChanged(row, row->size, removed, 0);
+  }
+  E.cy++;
+  E.cx=0;
+}
+
+void editorInsertText(const char *s, size_t len) {
+  /* typing all of s at the cursor, a row it goes into gets rendered
+     & highlighted once instead of once a character
+  */
+  while (1) {
+    const char *newline = memchr(s, '\n', len);
+    size_t run = newline ? (size_t)(newline - s) : len;
+    if (run) {
+      if (E.cy == E.numrows) {
+        editorInsertRow(E.numrows, "", 0);
+      }
+      editorRowInsertString(&E.row[E.cy], E.cx, s, run);
+      E.cx += run;
+    }
+    if (newline == NULL) {
+      break;
+    }
+    editorInsertNewLine();
+    s += run + 1;
+    len -= run + 1;
+  }
+}
+
+void editorDelChar() {
+  if (E.cy == E.numrows) {
+    /* return immediately if the cursor gets to 
+       the end of the file
+    */
+    return;
+  }
+  if (E.cx == 0 && E.cy == 0) {
+    /* return immediately if the cursor is at the 
+       beginning of the first line
+    */
+    return;
+  }
+  erow *row = &E.row[E.cy];
+  if (E.cx > 0) {
+    ptrdiff_t prev = editorRowPrevChar(row, E.cx);
+    editorRowDelChar(row, prev);
+    E.cx = prev;
+  }
+  else {
+    /* setting the cursor at the end of the previous row
+       before appending
+    */
+    E.cx = E.row[E.cy-1].size;
+    editorRowAppendString(&E.row[E.cy-1], row->chars, row->size);
+    editorDelRow(E.cy);
+    E.cy--;
+  }
+}
+
+void editorClampCursor() {
+  // keeping the cursor inside of the row it's on
+  erow *row = (E.cy >= E.numrows) ? NULL : &E.row[E.cy];
+  ptrdiff_t rowlen = row ? row->size : 0;
+  if (E.cx > rowlen) {
+    // limiting the cursor for not to go beyond the endline;
+    E.cx = rowlen;
+  }
+  if (row) {
+    // the cursor kept its cx, which may be inside a character now
+    E.cx = editorRowCharStart(row, E.cx);
+  }
+}
+
+void editorJumpToRow(ptrdiff_t filerow) {
+
+  /* putting the cursor straight on a row, as far away as it is. the
+     rows are an array, so that takes no longer than the next one
+  */
+  if (filerow < 0) {
+    filerow = 0;
+  }
+  if (filerow > E.numrows) {
+    filerow = E.numrows;
+  }
+  E.cy = filerow;
+  editorClampCursor();
+}
+
+/*** file i/o ***/
+
+char *editorRowsToString(size_t *buflen) {
+  size_t totallen=0;
+  // getting the total size to be copied
+  for (ptrdiff_t j=0; j<E.numrows; j++) {
+    totallen = totallen + E.row[j].size + 1;
+  }
+  *buflen = totallen;
+  char *buf = editorMallocArray(totallen, 1);
+  char *p = buf;
+  for (ptrdiff_t j=0; j<E.numrows; j++) {
+    memcpy(p, E.row[j].chars, E.row[j].size);
+    p = p + E.row[j].size;
+    // appending the new line character after each row
+    *p = '\n';
+    p++;
+  }
+  return buf;
+  // the caller function will free the buf
+}
+
+void editorCloseFile() {
+  // emptying the buffer, so another file can be opened in it
+  for (ptrdiff_t j=0; j<E.numrows; j++) {
+    editorFreeRow(&E.row[j]);
+  }
+  editorRowFree(MEMORY_ROWS, E.row);
+  E.row = NULL;
+  E.numrows = 0;
+  E.cx = E.cy = E.rx = 0;
+  E.rowoff = E.coloff = E.wrapoff = 0;
+  free(E.filename);
+  E.filename = NULL;
+  E.syntax = NULL;
+  E.hlstale = E.hlstalecount = 0;
+  E.dirty = 0;
+  if (E.index) {
+    editorIndexClear(E.index);
+  }
+}
+
+int editorOpen(char *filename) {
+  /* reading a file into the buffer, returns -1 with errno set if
+     it can't be opened
+  */
+  // taking a filename & opens it for reading by fopen()
+  FILE *fp = fopen(filename, "r");
+  if (!fp) {
+    return -1;
+  }
+  free(E.filename);
+  E.filename = strdup(filename);
+  if (E.filename == NULL) {
+    die("strdup");
+  }
+  // the rows get highlighted all at once when they're in
+  E.syntax = NULL;
+  char *line = NULL;
+  size_t linecap = 0;
+  ssize_t len;
+  /* getting the line & len from getline() instead of hardcoded
+     getline returns the length of the line it reads
+     or -1 when it is the end of the file i.e. no more lines
+     to read
+  */
+  while ((len = getline(&line, &linecap, fp)) != -1) {
+    while (len>0 && (line[len-1]=='\n' || line[len-1]=='\r')) {
+      /* stripping the newline '\n' & carriage return '\r'
+         from the line we consider. It's a one liner. so it will
+         be redundant to include newline or carriage return
+      */
+      len--;
+    }
+    editorInsertRow(E.numrows, line, len);
+  }
+  free(line);
+  fclose(fp);
+  editorSelectSyntaxHighlight();
+  E.dirty = 0;
+  return 0;
+}
+
+int editorSaveFile() {
+  /* writing the buffer to E.filename, returns -1 with errno set if
+     it can't be written. the status message says how it went
+  */
+  size_t len;
+  char *buf = editorRowsToString(&len);
+  /* opening E.filename
+     if it's new, then create a file. that's why O_CREAT used
+     if it exists, then open the file for read and write.
+     Thats's why O_RDWR is used.
+     OCREAT's permission here is  0644.
+     The 0644 permits that the owner can read and write 
+     whenever they want
+     otherwise the user can only read
+  */
+  int fd = open(E.filename, O_RDWR | O_CREAT, 0644);
+  if (fd != -1) {
+    if (ftruncate(fd, (off_t)len) != -1) {
+      /* write() can stop short of len, it never writes more than
+         about 2 GB at once on Linux
+      */
+      size_t written = 0;
+      while (written < len) {
+        ssize_t n = write(fd, buf + written, len - written);
+        if (n == -1 && errno == EINTR) {
+          continue;
+        }
+        if (n <= 0) {
+          break;
+        }
+        written += (size_t)n;
+      }
+      if (written == len) {
+        close(fd);
+        free(buf);
+        E.dirty = 0;
+        editorSetStatusMessage("%zu bytes written to disk", len);
+        return 0;
+      }
+    }
+    int saved = errno;
+    close(fd);
+    errno = saved;
+  }
+
+  free(buf);
+  editorSetStatusMessage("Can't save !! I/O error: %s", 
+    strerror(errno));
+  return -1;
+}
+
+/*** search engine ***/
+
+int editorFoldCase(int c) {
+  // only ASCII letters have a case here
+  return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+int editorIsWordChar(int c) {
+  // bytes of UTF-8 characters count as letters
+  return isalnum(c) || c == '_' || c >= 0x80;
+}
+
+void editorSearchFree(editorSearch *search) {
+  free(search->pattern);
+  free(search->query);
+  editorRegexFree(search->regex);
+  search->pattern = NULL;
+  search->query = NULL;
+  search->regex = NULL;
+  search->error = NULL;
+  search->len = 0;
+}
+
+int editorSearchCompile(editorSearch *search, const char *pattern, 
+  int flags) {
+  /* preparing a query once, so that every row it gets matched 
+     against can skip ahead by the Horspool shifts. a regex that
+     is just a string gets searched like one. returns -1 for an
+     invalid regex, which then matches nothing
+  */
+  editorSearchFree(search);
+  search->pattern = strdup(pattern);
+  if (search->pattern == NULL) {
+    die("strdup");
+  }
+  search->flags = flags;
+  char *literal = NULL;
+  if (flags & SEARCH_REGEX) {
+    search->regex = editorRegexCompile(pattern, flags, &literal, 
+      &search->error);
+    if (literal == NULL) {
+      return search->error ? -1 : 0;
+    }
+  }
+  const char *query = literal ? literal : pattern;
+  search->len = strlen(query);
+  search->query = editorMallocArray(search->len + 1, 1);
+  for (ptrdiff_t j=0; j<=search->len; j++) {
+    unsigned char c = query[j];
+    search->query[j] = (flags & SEARCH_IGNORE_CASE) ? 
+      editorFoldCase(c) : c;
+  }
+  free(literal);
+#ifdef __SSE2__
+  /* the first, the second & the last byte of the query are the ones
+     editorSearchForward() compares 16 positions at a time
+  */
+  ptrdiff_t m = search->len;
+  search->offsets[0] = 0;
+  search->offsets[1] = (m > 2) ? 1 : 0;
+  search->offsets[2] = (m > 0) ? m - 1 : 0;
+  for (int k=0; k<3; k++) {
+    unsigned char c = search->query[search->offsets[k]];
+    search->lower[k] = _mm_set1_epi8(c);
+    search->upper[k] = _mm_set1_epi8((flags & SEARCH_IGNORE_CASE && 
+      c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c);
+  }
+#endif
+  for (int c=0; c<256; c++) {
+    search->shift[c] = search->len;
+  }
+  for (ptrdiff_t j=0; j<search->len-1; j++) {
+    unsigned char c = search->query[j];
+    search->shift[c] = search->len - 1 - j;
+    if (flags & SEARCH_IGNORE_CASE && c >= 'a' && c <= 'z') {
+      search->shift[c - ('a' - 'A')] = search->len - 1 - j;
+    }
+  }
+  return 0;
+}
+
+int editorSearchWholeWord(const char *text, ptrdiff_t len, 
+  ptrdiff_t start, ptrdiff_t end) {
+  // a match that doesn't continue a word on either side of it
+  const unsigned char *t = (const unsigned char *)text;
+  if (start > 0 && start < end && editorIsWordChar(t[start-1]) && 
+    editorIsWordChar(t[start])) {
+    return 0;
+  }
+  if (end < len && end > start && editorIsWordChar(t[end-1]) && 
+    editorIsWordChar(t[end])) {
+    return 0;
+  }
+  return 1;
+}
+
+int editorSearchMatchAt(editorSearch *search, const char *text, 
+  ptrdiff_t len, ptrdiff_t at) {
+  // checking the whole query & the word boundaries around it
+  const unsigned char *t = (const unsigned char *)text;
+  if (search->flags & SEARCH_IGNORE_CASE) {
+    for (ptrdiff_t j=0; j<search->len; j++) {
+      if (editorFoldCase(t[at+j]) != (unsigned char)search->query[j]) {
+        return 0;
+      }
+    }
+  }
+  else if (memcmp(&text[at], search->query, search->len) != 0) {
+    return 0;
+  }
+  return !(search->flags & SEARCH_WHOLE_WORD) || 
+    editorSearchWholeWord(text, len, at, at + search->len);
+}
+
+ptrdiff_t editorSearchForward(editorSearch *search, const char *text, 
+  ptrdiff_t len, ptrdiff_t from) {
+  /* position of the first match in text[0 .. len) starting at from
+     or after it, -1 if there is none
+  */
+  if (search->regex) {
+    return editorRegexForward(search, text, len, from);
+  }
+  ptrdiff_t m = search->len;
+  if (m == 0 || from < 0) {
+    return -1;
+  }
+  ptrdiff_t i = from;
+#ifdef __SSE2__
+  /* comparing three bytes of the query against 16 positions at 
+     once, only the positions where all of them agree get checked 
+     completely
+  */
+  // the last block starting position that stays inside the text
+  ptrdiff_t lastblock = len - m - 15;
+  while (i <= lastblock + 15 && lastblock >= from) {
+    /* the final block overlaps the one before it, positions that
+       were checked already get shifted out of its mask
+    */
+    ptrdiff_t block = (i <= lastblock) ? i : lastblock;
+    __m128i found = _mm_set1_epi8(-1);
+    for (ptrdiff_t k=0; k<3; k++) {
+      __m128i bytes = _mm_loadu_si128(
+        (const __m128i *)&text[block + search->offsets[k]]);
+      found = _mm_and_si128(found, _mm_or_si128(
+        _mm_cmpeq_epi8(bytes, search->lower[k]), 
+        _mm_cmpeq_epi8(bytes, search->upper[k])));
+    }
+    unsigned int mask = _mm_movemask_epi8(found) >> (i - block);
+    while (mask) {
+      ptrdiff_t at = i + __builtin_ctz(mask);
+      if (editorSearchMatchAt(search, text, len, at)) {
+        return at;
+      }
+      mask &= mask - 1;
+    }
+    i = block + 16;
+  }
+#endif
+  // Horspool on what is left, or on everything without SSE2
+  const unsigned char *t = (const unsigned char *)text;
+  unsigned char last_byte = search->query[m-1];
+  while (i + m <= len) {
+    unsigned char c = t[i + m - 1];
+    int folded = (search->flags & SEARCH_IGNORE_CASE) ? 
+      editorFoldCase(c) : c;
+    if (folded == last_byte && editorSearchMatchAt(search, text, len, i)) {
+      return i;
+    }
+    i += search->shift[c];
+  }
+  return -1;
+}
+
+ptrdiff_t editorSearchMatchEnd(editorSearch *search, const char *text, 
+  ptrdiff_t len, ptrdiff_t at) {
+  // where the match found at at ends, its length varies for a regex
+  if (search->regex) {
+    return editorDfaLongest(search->regex, text, len, at);
+  }
+  return at + search->len;
+}
+
+ptrdiff_t editorSearchNext(editorSearch *search, const char *text, 
+  ptrdiff_t len, ptrdiff_t at) {
+  /* where to go on looking after the match at at: its end, so the
+     matches found, counted & replaced never overlap, the leftmost 
+     one winning. an empty regex match moves on a byte
+  */
+  ptrdiff_t end = editorSearchMatchEnd(search, text, len, at);
+  return (end > at) ? end : at + 1;
+}
+
+ptrdiff_t editorSearchBackward(editorSearch *search, const char *text, 
+  ptrdiff_t len, ptrdiff_t before) {
+  /* position of the last match in text[0 .. len) starting before
+     "before", -1 if there is none
+  */
+  ptrdiff_t found = -1;
+  ptrdiff_t at = editorSearchForward(search, text, len, 0);
+  while (at != -1 && at < before) {
+    found = at;
+    at = editorSearchForward(search, text, len, 
+      editorSearchNext(search, text, len, at));
+  }
+  return found;
+}
+
+ptrdiff_t editorSearchStep(editorSearch *search, ptrdiff_t filerow, 
+  ptrdiff_t cx, int direction, ptrdiff_t step, ptrdiff_t *matchrow) {
+  /* searching the row step rows away from filerow in the given 
+     direction. step 0 is filerow from chars[cx] on (or before it
+     backwards), step numrows is filerow again, as a whole
+  */
+  ptrdiff_t current = (filerow + direction*step) % E.numrows;
+  if (current < 0) {
+    current += E.numrows;
+  }
+  erow *row = &E.row[current];
+  *matchrow = current;
+  if (direction > 0) {
+    return editorSearchForward(search, row->chars, row->size, 
+      step == 0 ? cx : 0);
+  }
+  return editorSearchBackward(search, row->chars, row->size, 
+    step == 0 ? cx : row->size + 1);
+}
+
+int editorSearchRows(editorSearch *search, ptrdiff_t filerow, ptrdiff_t cx, 
+  int direction, ptrdiff_t *matchrow, ptrdiff_t *matchcx) {
+  /* looking for the nearest match from chars[cx] of filerow on in
+     the given direction, wrapping around the file. a match at cx
+     itself counts when searching forward. returns 0 if the query
+     appears nowhere
+  */
+  if (E.numrows == 0) {
+    return 0;
+  }
+  for (ptrdiff_t step=0; step<=E.numrows; step++) {
+    ptrdiff_t at = editorSearchStep(search, filerow, cx, direction, step, 
+      matchrow);
+    if (at != -1) {
+      *matchcx = at;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void editorResultsAdd(editorSearchResults *results, ptrdiff_t row, 
+  ptrdiff_t cx) {
+
+  if (results->count == results->cap) {
+    results->cap = results->cap ? results->cap*2 : 64;
+    results->matches = editorReallocArray(results->matches, 
+      results->cap, sizeof(editorSearchMatch));
+  }
+  results->matches[results->count].row = row;
+  results->matches[results->count].cx = cx;
+  results->count++;
+}
+
+void editorResultsFree(editorSearchResults *results) {
+  free(results->matches);
+  results->matches = NULL;
+  results->count = results->cap = 0;
+}
+
+ptrdiff_t editorSearchCollectRange(editorSearch *search, 
+  ptrdiff_t filerow, ptrdiff_t from, ptrdiff_t len, 
+  editorSearchResults *results) {
+  /* adding the matches in chars[from .. len) of a row to results,
+     returns how many
+  */
+  char *chars = E.row[filerow].chars;
+  ptrdiff_t added = 0;
+  ptrdiff_t at = editorSearchForward(search, chars, len, from);
+  if (at != -1 && search->regex) {
+    return editorRegexStarts(search, chars, len, at, filerow, results);
+  }
+  while (at != -1) {
+    editorResultsAdd(results, filerow, at);
+    added++;
+    at = editorSearchForward(search, chars, len, 
+      editorSearchNext(search, chars, len, at));
+  }
+  return added;
+}
+
+ptrdiff_t editorSearchCollectRow(editorSearch *search, 
+  ptrdiff_t filerow, editorSearchResults *results) {
+
+  // adding every match of a row to results, returns how many
+  return editorSearchCollectRange(search, filerow, 0, 
+    E.row[filerow].size, results);
+}
+
+int editorResultsNearest(editorSearchResults *results, ptrdiff_t filerow, 
+  ptrdiff_t cx, int direction, ptrdiff_t *matchrow, ptrdiff_t *matchcx) {
+  /* editorSearchRows() on matches gathered already: the first one 
+     from chars[cx] of filerow on, or the last one before it, 
+     wrapping around the file
+  */
+  if (results->count == 0) {
+    return 0;
+  }
+  // the first match that doesn't come before chars[cx] of filerow
+  ptrdiff_t low = 0, high = results->count;
+  while (low < high) {
+    ptrdiff_t middle = low + (high - low)/2;
+    editorSearchMatch *match = &results->matches[middle];
+    if (match->row < filerow || 
+      (match->row == filerow && match->cx < cx)) {
+      low = middle + 1;
+    }
+    else {
+      high = middle;
+    }
+  }
+  ptrdiff_t k;
+  if (direction > 0) {
+    k = (low == results->count) ? 0 : low;
+  }
+  else {
+    k = (low == 0) ? results->count - 1 : low - 1;
+  }
+  *matchrow = results->matches[k].row;
+  *matchcx = results->matches[k].cx;
+  return 1;
+}
+
+void editorResultsNarrow(editorSearch *search, 
+  editorSearchResults *results) {
+  /* the matches of a string that got longer, searched for only on 
+     the rows the shorter one matched on, there's nowhere else it
+     can match. they're searched again as a whole, the longer one 
+     can start inside what a shorter match left out for overlapping
+  */
+  editorSearchResults narrowed = {0};
+  for (ptrdiff_t k=0; k<results->count; k++) {
+    if (k == 0 || results->matches[k].row != results->matches[k-1].row) {
+      editorSearchCollectRow(search, results->matches[k].row, &narrowed);
+    }
+  }
+  editorResultsFree(results);
+  *results = narrowed;
+}
+
+/*** regex ***/
+
+int editorRegexNewSet(editorRegex *regex) {
+  if (regex->setcount == regex->setcap) {
+    regex->setcap = regex->setcap ? regex->setcap*2 : 16;
+    regex->sets = editorReallocArray(regex->sets, regex->setcap, 
+      sizeof(regex->sets[0]));
+  }
+  memset(regex->sets[regex->setcount], 0, sizeof(regex->sets[0]));
+  return regex->setcount++;
+}
+
+void editorRegexSetAdd(unsigned char *set, int low, int high) {
+  for (int c=low; c<=high; c++) {
+    set[c >> 3] |= 1 << (c & 7);
+  }
+}
+
+int editorRegexSetHas(const unsigned char *set, int c) {
+  return set[c >> 3] & (1 << (c & 7));
+}
+
+int editorRegexAstNode(editorRegexParser *parser, int op, int left, 
+  int right) {
+  if (parser->astcount == parser->astcap) {
+    parser->astcap = parser->astcap ? parser->astcap*2 : 64;
+    parser->ast = editorReallocArray(parser->ast, parser->astcap, 
+      sizeof(editorRegexAst));
+  }
+  editorRegexAst *ast = &parser->ast[parser->astcount];
+  ast->op = op;
+  ast->left = left;
+  ast->right = right;
+  ast->set = -1;
+  ast->min = ast->max = 0;
+  return parser->astcount++;
+}
+
+int editorRegexSetNode(editorRegexParser *parser, int set) {
+  int node = editorRegexAstNode(parser, AST_SET, -1, -1);
+  parser->ast[node].set = set;
+  return node;
+}
+
+int editorRegexRange(editorRegexParser *parser, int low, int high) {
+  int set = editorRegexNewSet(parser->regex);
+  editorRegexSetAdd(parser->regex->sets[set], low, high);
+  return editorRegexSetNode(parser, set);
+}
+
+int editorRegexCat(editorRegexParser *parser, int left, int right) {
+  if (parser->ast[left].op == AST_EMPTY) {
+    return right;
+  }
+  return editorRegexAstNode(parser, AST_CAT, left, right);
+}
+
+int editorRegexLiteral(editorRegexParser *parser, int c) {
+  // a byte of the pattern, in both cases if the case gets ignored
+  int set = editorRegexNewSet(parser->regex);
+  unsigned char *bits = parser->regex->sets[set];
+  editorRegexSetAdd(bits, c, c);
+  if ((parser->flags & SEARCH_IGNORE_CASE) && isalpha(c)) {
+    editorRegexSetAdd(bits, tolower(c), tolower(c));
+    editorRegexSetAdd(bits, toupper(c), toupper(c));
+  }
+  return editorRegexSetNode(parser, set);
+}
+
+int editorRegexMultibyte(editorRegexParser *parser) {
+  /* any UTF-8 character longer than a byte: a lead byte followed by
+     as many continuation bytes as it announces
+  */
+  int node = -1;
+  for (int extra=1; extra<=3; extra++) {
+    int lead[3][2] = {{0xC0, 0xDF}, {0xE0, 0xEF}, {0xF0, 0xF7}};
+    int seq = editorRegexRange(parser, lead[extra-1][0], lead[extra-1][1]);
+    for (int k=0; k<extra; k++) {
+      seq = editorRegexCat(parser, seq, 
+        editorRegexRange(parser, 0x80, 0xBF));
+    }
+    node = (node == -1) ? seq : 
+      editorRegexAstNode(parser, AST_ALT, node, seq);
+  }
+  return node;
+}
+
+void editorRegexSingleBytes(unsigned char *bits) {
+  /* the bytes that are a character by themselves: ASCII, & bytes 
+     that can't be part of a UTF-8 sequence. a stray continuation 
+     byte is left out, or a match could start in the middle of a
+     character
+  */
+  memset(bits, 0, 32);
+  editorRegexSetAdd(bits, 0x00, 0x7F);
+  editorRegexSetAdd(bits, 0xF8, 0xFF);
+}
+
+int editorRegexClassEscape(int c, unsigned char *bits, int *multibyte) {
+  /* adding the class of \d, \w, \s or their negations to bits,
+     returns 0 if c names none of them. letters of other scripts
+     count as word characters like in editorIsWordChar()
+  */
+  unsigned char class[32];
+  int word = 0;
+  memset(class, 0, sizeof(class));
+  switch (tolower(c)) {
+  case 'd':
+    editorRegexSetAdd(class, '0', '9');
+    break;
+  case 'w':
+    editorRegexSetAdd(class, '0', '9');
+    editorRegexSetAdd(class, 'A', 'Z');
+    editorRegexSetAdd(class, 'a', 'z');
+    editorRegexSetAdd(class, '_', '_');
+    word = 1;
+    break;
+  case 's':
+    editorRegexSetAdd(class, '\t', '\r');
+    editorRegexSetAdd(class, ' ', ' ');
+    break;
+  default:
+    return 0;
+  }
+  if (isupper(c)) {
+    unsigned char single[32];
+    editorRegexSingleBytes(single);
+    for (int k=0; k<32; k++) {
+      class[k] = single[k] & ~class[k];
+    }
+    word = !word;
+  }
+  for (int k=0; k<32; k++) {
+    bits[k] |= class[k];
+  }
+  if (word) {
+    *multibyte = 1;
+  }
+  return 1;
+}
+
+int editorRegexEscapedByte(int c) {
+  // the byte an escape like \t stands for, -1 for a letter without one
+  switch (c) {
+  case 't': return '\t';
+  case 'n': return '\n';
+  case 'r': return '\r';
+  case 'f': return '\f';
+  case 'v': return '\v';
+  }
+  return isalnum(c) ? -1 : c;
+}
+
+int editorRegexCharLen(const char *p) {
+  // bytes of the pattern character at p, a whole UTF-8 sequence
+  int cp;
+  return editorUtf8Decode(p, strlen(p), &cp);
+}
+
+int editorRegexParseClass(editorRegexParser *parser) {
+  /* [...] with ranges, \d \w \s & their negations. the members
+     longer than a byte become alternatives of their own, those 
+     can't be excluded by [^...] or be the end of a range
+  */
+  editorRegex *regex = parser->regex;
+  int set = editorRegexNewSet(regex);
+  unsigned char bits[32];
+  memset(bits, 0, sizeof(bits));
+  int multibyte = 0;
+  int others = -1; // alternatives of the multibyte members
+  int negate = 0;
+  parser->p++;
+  if (*parser->p == '^') {
+    negate = 1;
+    parser->p++;
+  }
+  int first = 1;
+  while (*parser->p != ']' || first) {
+    first = 0;
+    if (*parser->p == '\0') {
+      parser->error = "missing ]";
+      return -1;
+    }
+    int low;
+    if (*parser->p == '\\') {
+      int c = (unsigned char)parser->p[1];
+      if (c == '\0') {
+        parser->error = "trailing \\";
+        return -1;
+      }
+      parser->p += 2;
+      if (editorRegexClassEscape(c, bits, &multibyte)) {
+        continue;
+      }
+      if ((low = editorRegexEscapedByte(c)) == -1) {
+        parser->error = "unknown escape";
+        return -1;
+      }
+    }
+    else if ((unsigned char)*parser->p >= 0x80 && 
+      editorRegexCharLen(parser->p) > 1) {
+      int len = editorRegexCharLen(parser->p);
+      if (negate || parser->p[len] == '-') {
+        parser->error = "non-ASCII in [^...] or a range";
+        return -1;
+      }
+      int seq = editorRegexAstNode(parser, AST_EMPTY, -1, -1);
+      for (int k=0; k<len; k++) {
+        seq = editorRegexCat(parser, seq, 
+          editorRegexLiteral(parser, (unsigned char)parser->p[k]));
+      }
+      others = (others == -1) ? seq : 
+        editorRegexAstNode(parser, AST_ALT, others, seq);
+      parser->p += len;
+      continue;
+    }
+    else {
+      low = (unsigned char)*parser->p++;
+    }
+    int high = low;
+    if (parser->p[0] == '-' && parser->p[1] != ']' && parser->p[1]) {
+      high = (unsigned char)parser->p[1];
+      parser->p += 2;
+      if (high == '\\' && parser->p[0]) {
+        high = editorRegexEscapedByte((unsigned char)*parser->p++);
+      }
+      if (high < low || high >= 0x80) {
+        parser->error = "bad range";
+        return -1;
+      }
+    }
+    editorRegexSetAdd(bits, low, high);
+  }
+  parser->p++;
+  if (parser->flags & SEARCH_IGNORE_CASE) {
+    for (int c='a'; c<='z'; c++) {
+      if (editorRegexSetHas(bits, c) || 
+        editorRegexSetHas(bits, toupper(c))) {
+        editorRegexSetAdd(bits, c, c);
+        editorRegexSetAdd(bits, toupper(c), toupper(c));
+      }
+    }
+  }
+  if (negate) {
+    unsigned char single[32];
+    editorRegexSingleBytes(single);
+    for (int k=0; k<32; k++) {
+      bits[k] = single[k] & ~bits[k];
+    }
+    multibyte = !multibyte;
+  }
+  memcpy(regex->sets[set], bits, sizeof(bits));
+  int node = editorRegexSetNode(parser, set);
+  if (multibyte) {
+    node = editorRegexAstNode(parser, AST_ALT, node, 
+      editorRegexMultibyte(parser));
+  }
+  if (others != -1) {
+    node = editorRegexAstNode(parser, AST_ALT, node, others);
+  }
+  return node;
+}
+
+int editorRegexParseAlt(editorRegexParser *parser);
+
+int editorRegexParseAtom(editorRegexParser *parser) {
+  unsigned char c = *parser->p;
+  switch (c) {
+  case '(': {
+    parser->p++;
+    int node = editorRegexParseAlt(parser);
+    if (node == -1) {
+      return -1;
+    }
+    if (*parser->p != ')') {
+      parser->error = "missing )";
+      return -1;
+    }
+    parser->p++;
+    return node;
+  }
+  case '[':
+    return editorRegexParseClass(parser);
+  case '.': {
+    parser->p++;
+    int set = editorRegexNewSet(parser->regex);
+    editorRegexSingleBytes(parser->regex->sets[set]);
+    return editorRegexAstNode(parser, AST_ALT, 
+      editorRegexSetNode(parser, set), editorRegexMultibyte(parser));
+  }
+  case '^':
+    parser->p++;
+    return editorRegexAstNode(parser, AST_BEGIN, -1, -1);
+  case '$':
+    parser->p++;
+    return editorRegexAstNode(parser, AST_END, -1, -1);
+  case '*': case '+': case '?':
+    parser->error = "nothing to repeat";
+    return -1;
+  case '\\': {
+    int next = (unsigned char)parser->p[1];
+    if (next == '\0') {
+      parser->error = "trailing \\";
+      return -1;
+    }
+    parser->p += 2;
+    int set = editorRegexNewSet(parser->regex);
+    int multibyte = 0;
+    if (editorRegexClassEscape(next, parser->regex->sets[set], 
+      &multibyte)) {
+      int node = editorRegexSetNode(parser, set);
+      if (multibyte) {
+        node = editorRegexAstNode(parser, AST_ALT, node, 
+          editorRegexMultibyte(parser));
+      }
+      return node;
+    }
+    int byte = editorRegexEscapedByte(next);
+    if (byte == -1) {
+      parser->error = "unknown escape";
+      return -1;
+    }
+    return editorRegexLiteral(parser, byte);
+  }
+  }
+  // a character, all the bytes of it so that a repeat takes them all
+  int len = editorRegexCharLen(parser->p);
+  int node = editorRegexAstNode(parser, AST_EMPTY, -1, -1);
+  for (int k=0; k<len; k++) {
+    node = editorRegexCat(parser, node, 
+      editorRegexLiteral(parser, (unsigned char)*parser->p++));
+  }
+  return node;
+}
+
+int editorRegexParseCount(editorRegexParser *parser, int *min, int *max) {
+  /* {m}, {m,} or {m,n} after an atom, anything else starting with
+     { is taken literally
+  */
+  const char *p = parser->p + 1;
+  if (!isdigit((unsigned char)*p)) {
+    return 0;
+  }
+  *min = strtol(p, (char **)&p, 10);
+  *max = *min;
+  if (*p == ',') {
+    p++;
+    *max = -1;
+    if (isdigit((unsigned char)*p)) {
+      *max = strtol(p, (char **)&p, 10);
+    }
+  }
+  if (*p != '}') {
+    return 0;
+  }
+  parser->p = p;
+  return 1;
+}
+
+int editorRegexParseRepeat(editorRegexParser *parser) {
+  int node = editorRegexParseAtom(parser);
+  while (node != -1) {
+    int min, max;
+    char c = *parser->p;
+    if (c == '*') {
+      min = 0, max = -1;
+    }
+    else if (c == '+') {
+      min = 1, max = -1;
+    }
+    else if (c == '?') {
+      min = 0, max = 1;
+    }
+    else if (c != '{' || !editorRegexParseCount(parser, &min, &max)) {
+      break;
+    }
+    if (min < 0 || min > 1000 || max > 1000 || 
+      (max != -1 && max < min)) {
+      parser->error = "bad repeat count";
+      return -1;
+    }
+    parser->p++;
+    node = editorRegexAstNode(parser, AST_REPEAT, node, -1);
+    parser->ast[node].min = min;
+    parser->ast[node].max = max;
+  }
+  return node;
+}
+
+int editorRegexParseCat(editorRegexParser *parser) {
+  int node = editorRegexAstNode(parser, AST_EMPTY, -1, -1);
+  while (*parser->p && *parser->p != '|' && *parser->p != ')') {
+    int next = editorRegexParseRepeat(parser);
+    if (next == -1) {
+      return -1;
+    }
+    node = editorRegexCat(parser, node, next);
+  }
+  return node;
+}
+
+int editorRegexParseAlt(editorRegexParser *parser) {
+  int node = editorRegexParseCat(parser);
+  while (node != -1 && *parser->p == '|') {
+    parser->p++;
+    int next = editorRegexParseCat(parser);
+    if (next == -1) {
+      return -1;
+    }
+    node = editorRegexAstNode(parser, AST_ALT, node, next);
+  }
+  return node;
+}
+
+int editorRegexAddNode(editorRegex *regex, int op, int out, int out1, 
+  int set) {
+  if (regex->nodecount == CODIBLE_REGEX_NODES) {
+    return -1;
+  }
+  if (regex->nodecount == regex->nodecap) {
+    regex->nodecap = regex->nodecap ? regex->nodecap*2 : 64;
+    regex->nodes = editorReallocArray(regex->nodes, regex->nodecap, 
+      sizeof(editorRegexNode));
+  }
+  editorRegexNode *node = &regex->nodes[regex->nodecount];
+  node->op = op;
+  node->out = out;
+  node->out1 = out1;
+  node->set = set;
+  return regex->nodecount++;
+}
+
+int editorRegexEmit(editorRegex *regex, editorRegexAst *tree, int ast, 
+  int next, int reverse) {
+  /* the NFA nodes of a part of the regex, built from its end: next
+     is where they lead to & the entry node gets returned. reverse
+     builds the NFA of the regex read backwards, where ^ & $ swap 
+     places. -1 means the NFA got too big
+  */
+  if (next == -1) {
+    return -1;
+  }
+  editorRegexAst *node = &tree[ast];
+  switch (node->op) {
+  case AST_SET:
+    return editorRegexAddNode(regex, RX_CHAR, next, -1, node->set);
+  case AST_EMPTY:
+    return next;
+  case AST_BEGIN:
+    return editorRegexAddNode(regex, reverse ? RX_END : RX_BEGIN, 
+      next, -1, -1);
+  case AST_END:
+    return editorRegexAddNode(regex, reverse ? RX_BEGIN : RX_END, 
+      next, -1, -1);
+  case AST_CAT: {
+    int first = reverse ? node->right : node->left;
+    int second = reverse ? node->left : node->right;
+    return editorRegexEmit(regex, tree, first, 
+      editorRegexEmit(regex, tree, second, next, reverse), reverse);
+  }
+  case AST_ALT: {
+    int left = editorRegexEmit(regex, tree, node->left, next, reverse);
+    int right = editorRegexEmit(regex, tree, node->right, next, reverse);
+    if (left == -1 || right == -1) {
+      return -1;
+    }
+    return editorRegexAddNode(regex, RX_SPLIT, left, right, -1);
+  }
+  case AST_REPEAT: {
+    int current = next;
+    if (node->max == -1) {
+      // a loop back in front of the body
+      int loop = editorRegexAddNode(regex, RX_SPLIT, -1, next, -1);
+      int body = editorRegexEmit(regex, tree, node->left, loop, reverse);
+      if (loop == -1 || body == -1) {
+        return -1;
+      }
+      regex->nodes[loop].out = body;
+      current = loop;
+    }
+    else {
+      // each optional copy may skip all the ones after it
+      for (int k=node->min; k<node->max && current!=-1; k++) {
+        int body = editorRegexEmit(regex, tree, node->left, current, 
+          reverse);
+        current = (body == -1) ? -1 : 
+          editorRegexAddNode(regex, RX_SPLIT, body, next, -1);
+      }
+    }
+    for (int k=0; k<node->min; k++) {
+      current = editorRegexEmit(regex, tree, node->left, current, 
+        reverse);
+    }
+    return current;
+  }
+  }
+  return -1;
+}
+
+int editorRegexSetByte(editorRegexParser *parser, int set) {
+  /* the byte a set stands for if it's a single one, folded to 
+     lower case if it's the two cases of a letter & the case gets 
+     ignored. -1 otherwise
+  */
+  unsigned char *bits = parser->regex->sets[set];
+  int found = -1, count = 0;
+  for (int c=0; c<256; c++) {
+    if (editorRegexSetHas(bits, c)) {
+      count++;
+      found = c;
+    }
+  }
+  if (count == 1) {
+    return found;
+  }
+  if (count == 2 && (parser->flags & SEARCH_IGNORE_CASE) && 
+    isalpha(found) && editorRegexSetHas(bits, tolower(found))) {
+    return tolower(found);
+  }
+  return -1;
+}
+
+int editorRegexPrefix(editorRegexParser *parser, int ast, char *prefix, 
+  int *len) {
+  /* appending the bytes every match of ast starts with. returns 1 
+     if that's all ast matches, so the part after it can add more
+  */
+  editorRegexAst *node = &parser->ast[ast];
+  switch (node->op) {
+  case AST_EMPTY:
+    return 1;
+  case AST_SET: {
+    int c = editorRegexSetByte(parser, node->set);
+    if (c <= 0 || *len == CODIBLE_REGEX_PREFIX) {
+      return 0;
+    }
+    prefix[(*len)++] = c;
+    return 1;
+  }
+  case AST_CAT:
+    return editorRegexPrefix(parser, node->left, prefix, len) && 
+      editorRegexPrefix(parser, node->right, prefix, len);
+  case AST_REPEAT:
+    if (node->min >= 1) {
+      editorRegexPrefix(parser, node->left, prefix, len);
+    }
+    return 0;
+  }
+  return 0;
+}
+
+void editorRegexEndRun(char *run, int *runlen, char *best, int *bestlen) {
+  if (*runlen > *bestlen) {
+    memcpy(best, run, *runlen);
+    *bestlen = *runlen;
+  }
+  *runlen = 0;
+}
+
+void editorRegexRequired(editorRegexParser *parser, int ast, char *run, 
+  int *runlen, char *best, int *bestlen) {
+  /* reading ast from left to right, bytes that every match has one
+     after the other make up a run, anything else ends it. the 
+     longest run ends up in best, no match can do without it
+  */
+  editorRegexAst *node = &parser->ast[ast];
+  switch (node->op) {
+  case AST_EMPTY:
+    return;
+  case AST_SET: {
+    int c = editorRegexSetByte(parser, node->set);
+    if (c > 0 && *runlen < CODIBLE_REGEX_PREFIX) {
+      run[(*runlen)++] = c;
+      return;
+    }
+    break;
+  }
+  case AST_CAT:
+    editorRegexRequired(parser, node->left, run, runlen, best, bestlen);
+    editorRegexRequired(parser, node->right, run, runlen, best, bestlen);
+    return;
+  case AST_REPEAT:
+    // the first time around follows what came before
+    if (node->min >= 1) {
+      editorRegexRequired(parser, node->left, run, runlen, best, 
+        bestlen);
+    }
+    break;
+  }
+  editorRegexEndRun(run, runlen, best, bestlen);
+}
+
+void editorRegexClasses(editorRegex *regex) {
+  /* splitting the bytes into classes by every set in turn, two 
+     bytes stay in the same class only if no set tells them apart
+  */
+  memset(regex->classes, 0, sizeof(regex->classes));
+  regex->classcount = 1;
+  for (int s=0; s<regex->setcount; s++) {
+    int split[2][256];
+    memset(split, -1, sizeof(split));
+    int count = 0;
+    for (int c=0; c<256; c++) {
+      int in = editorRegexSetHas(regex->sets[s], c) ? 1 : 0;
+      int *class = &split[in][regex->classes[c]];
+      if (*class == -1) {
+        *class = count++;
+      }
+      regex->classes[c] = *class;
+    }
+    regex->classcount = count;
+  }
+}
+
+void editorDfaInit(editorRegex *regex, editorDfa *dfa, int entry, 
+  int unanchored) {
+  memset(dfa, 0, sizeof(*dfa));
+  dfa->entry = entry;
+  dfa->unanchored = unanchored;
+  dfa->width = regex->classcount + 1;
+  dfa->first = editorMallocArray(CODIBLE_DFA_STATES, sizeof(int));
+  dfa->size = editorMallocArray(CODIBLE_DFA_STATES, sizeof(int));
+  dfa->next = editorMallocArray((ptrdiff_t)CODIBLE_DFA_STATES*dfa->width, 
+    sizeof(int));
+  dfa->hash = editorMallocArray(CODIBLE_DFA_STATES*2, sizeof(int));
+  memset(dfa->hash, -1, sizeof(int)*CODIBLE_DFA_STATES*2);
+  dfa->listcap = 256;
+  dfa->lists = editorMallocArray(dfa->listcap, sizeof(int));
+  dfa->starts[0] = dfa->starts[1] = -1;
+}
+
+void editorDfaFree(editorDfa *dfa) {
+  free(dfa->first);
+  free(dfa->size);
+  free(dfa->lists);
+  free(dfa->next);
+  free(dfa->hash);
+}
+
+void editorDfaFlush(editorDfa *dfa) {
+  // forgetting every state, the ones needed get built again
+  dfa->count = 0;
+  dfa->listlen = 0;
+  dfa->flushes++;
+  memset(dfa->hash, -1, sizeof(int)*CODIBLE_DFA_STATES*2);
+  dfa->starts[0] = dfa->starts[1] = -1;
+}
+
+void editorRegexClosure(editorRegex *regex, int node, int atbegin, 
+  int atend, int *list, int *count) {
+  /* adding the nodes that read a byte, match or wait for the end 
+     of the row to list, starting at node & following the ones that
+     go on without reading. nodes marked in this round are skipped
+  */
+  int top = 0;
+  regex->stack[top++] = node;
+  while (top) {
+    int n = regex->stack[--top];
+    if (regex->marks[n] == regex->mark) {
+      continue;
+    }
+    regex->marks[n] = regex->mark;
+    editorRegexNode *x = &regex->nodes[n];
+    switch (x->op) {
+    case RX_SPLIT:
+      regex->stack[top++] = x->out1;
+      regex->stack[top++] = x->out;
+      break;
+    case RX_BEGIN:
+      if (atbegin) {
+        regex->stack[top++] = x->out;
+      }
+      break;
+    case RX_END:
+      if (atend) {
+        regex->stack[top++] = x->out;
+      }
+      else {
+        list[(*count)++] = n;
+      }
+      break;
+    default:
+      list[(*count)++] = n;
+    }
+  }
+}
+
+int editorRegexCompareNodes(const void *a, const void *b) {
+  return *(const int *)a - *(const int *)b;
+}
+
+int editorDfaState(editorRegex *regex, editorDfa *dfa, int *list, 
+  int count) {
+  /* the row in next of the state of a set of NFA nodes, made up if 
+     it's new
+  */
+  qsort(list, count, sizeof(int), editorRegexCompareNodes);
+  unsigned int hash = 2166136261u;
+  for (int k=0; k<count; k++) {
+    hash = (hash ^ list[k]) * 16777619u;
+  }
+  int mask = CODIBLE_DFA_STATES*2 - 1;
+  int slot = hash & mask;
+  while (dfa->hash[slot] != -1) {
+    int id = dfa->hash[slot];
+    if (dfa->size[id] == count && memcmp(&dfa->lists[dfa->first[id]], 
+      list, sizeof(int)*count) == 0) {
+      return id*dfa->width;
+    }
+    slot = (slot + 1) & mask;
+  }
+  if (dfa->count == CODIBLE_DFA_STATES) {
+    editorDfaFlush(dfa);
+    slot = hash & mask;
+  }
+  int id = dfa->count++;
+  dfa->hash[slot] = id;
+  if (dfa->listlen + count > dfa->listcap) {
+    dfa->listcap = (dfa->listlen + count)*2;
+    dfa->lists = editorReallocArray(dfa->lists, dfa->listcap, 
+      sizeof(int));
+  }
+  dfa->first[id] = dfa->listlen;
+  dfa->size[id] = count;
+  memcpy(&dfa->lists[dfa->listlen], list, sizeof(int)*count);
+  dfa->listlen += count;
+
+  int accept = (count == 0) ? DFA_DEAD : 0;
+  int ends = 0;
+  for (int k=0; k<count; k++) {
+    int op = regex->nodes[list[k]].op;
+    if (op == RX_MATCH) {
+      accept |= DFA_ACCEPT | DFA_ACCEPT_END;
+    }
+    ends |= (op == RX_END);
+  }
+  if (ends && !(accept & DFA_ACCEPT)) {
+    // whether getting past the $ nodes leads to a match
+    int endcount = 0;
+    regex->mark++;
+    for (int k=0; k<count; k++) {
+      if (regex->nodes[list[k]].op == RX_END) {
+        editorRegexClosure(regex, regex->nodes[list[k]].out, 0, 1, 
+          regex->endlist, &endcount);
+      }
+    }
+    for (int k=0; k<endcount; k++) {
+      if (regex->nodes[regex->endlist[k]].op == RX_MATCH) {
+        accept |= DFA_ACCEPT_END;
+      }
+    }
+  }
+  int *row = &dfa->next[id*dfa->width];
+  row[0] = accept;
+  memset(&row[1], -1, sizeof(int)*(dfa->width - 1));
+  return id*dfa->width;
+}
+
+int editorDfaStart(editorRegex *regex, editorDfa *dfa, int atbegin) {
+  if (dfa->starts[atbegin] == -1) {
+    int count = 0;
+    regex->mark++;
+    editorRegexClosure(regex, dfa->entry, atbegin, 0, regex->list, 
+      &count);
+    int state = editorDfaState(regex, dfa, regex->list, count);
+    dfa->starts[atbegin] = state;
+  }
+  return dfa->starts[atbegin];
+}
+
+int editorDfaStep(editorRegex *regex, editorDfa *dfa, int state, int c) {
+  /* the transition of state on byte c that wasn't taken before. the
+     transition only gets kept if the states weren't flushed meanwhile
+  */
+  int count = 0;
+  int id = state / dfa->width;
+  regex->mark++;
+  int *nodes = &dfa->lists[dfa->first[id]];
+  for (int k=0; k<dfa->size[id]; k++) {
+    editorRegexNode *x = &regex->nodes[nodes[k]];
+    if (x->op == RX_CHAR && editorRegexSetHas(regex->sets[x->set], c)) {
+      editorRegexClosure(regex, x->out, 0, 0, regex->list, &count);
+    }
+  }
+  if (dfa->unanchored) {
+    editorRegexClosure(regex, dfa->entry, 0, 0, regex->list, &count);
+  }
+  int flushes = dfa->flushes;
+  int next = editorDfaState(regex, dfa, regex->list, count);
+  if (dfa->flushes == flushes) {
+    /* a transition into a state where the search may stop is kept
+       as -2 - its row, so a loop reading the text only has to look
+       at the flags when it gets a negative one
+    */
+    int stops = dfa->next[next] & (DFA_ACCEPT | DFA_DEAD);
+    dfa->next[state + 1 + regex->classes[c]] = stops ? -2 - next : next;
+  }
+  return next;
+}
+
+int editorDfaTarget(editorRegex *regex, editorDfa *dfa, int state, 
+  int c, int to) {
+  // the row a negative transition leads to
+  return (to == -1) ? editorDfaStep(regex, dfa, state, c) : -2 - to;
+}
+
+ptrdiff_t editorDfaSearch(editorRegex *regex, const char *text, 
+  ptrdiff_t len, ptrdiff_t from) {
+  /* where the first match to end from from on ends, -1 if there
+     is none. while no match is under way the literal prefix of the
+     regex gets skipped to
+  */
+  editorDfa *dfa = &regex->dfas[DFA_SEARCH];
+  const unsigned char *t = (const unsigned char *)text;
+  const unsigned char *classes = regex->classes;
+  int *next = dfa->next;
+  int state, idle, flushes;
+  do {
+    flushes = dfa->flushes;
+    idle = regex->hasprefix ? editorDfaStart(regex, dfa, 0) : -1;
+    state = editorDfaStart(regex, dfa, from == 0);
+  } while (flushes != dfa->flushes);
+  if (next[state] & DFA_ACCEPT) {
+    return from;
+  }
+  for (ptrdiff_t i=from; i<len; i++) {
+    if (state == idle) {
+      i = editorSearchForward(&regex->prefix, text, len, i);
+      if (i == -1) {
+        return -1;
+      }
+    }
+    int to = next[state + 1 + classes[t[i]]];
+    if (to < 0) {
+      flushes = dfa->flushes;
+      to = editorDfaTarget(regex, dfa, state, t[i], to);
+      if (flushes != dfa->flushes && regex->hasprefix) {
+        // the start state is a different one now
+        idle = editorDfaStart(regex, dfa, 0);
+      }
+      if (next[to] & DFA_ACCEPT) {
+        return i + 1;
+      }
+      if (next[to] & DFA_DEAD) {
+        return -1;
+      }
+    }
+    state = to;
+  }
+  return (next[state] & DFA_ACCEPT_END) ? len : -1;
+}
+
+ptrdiff_t editorDfaFirstStart(editorRegex *regex, const char *text, 
+  ptrdiff_t len, ptrdiff_t from) {
+  /* reading the row backwards from its end down to from, where the
+     leftmost match starting at from or after it starts
+  */
+  editorDfa *dfa = &regex->dfas[DFA_STARTS];
+  const unsigned char *t = (const unsigned char *)text;
+  int *next = dfa->next;
+  int state = editorDfaStart(regex, dfa, 1);
+  ptrdiff_t found = (next[state] & DFA_ACCEPT) ? len : -1;
+  ptrdiff_t i;
+  for (i=len-1; i>=from; i--) {
+    int to = next[state + 1 + regex->classes[t[i]]];
+    state = (to < 0) ? editorDfaTarget(regex, dfa, state, t[i], to) : to;
+    if (next[state] & DFA_ACCEPT) {
+      found = i;
+    }
+    if (next[state] & DFA_DEAD) {
+      return found;
+    }
+  }
+  // a match that needs the row to begin where it starts
+  if (i < 0 && (next[state] & DFA_ACCEPT_END)) {
+    found = 0;
+  }
+  return found;
+}
+
+void editorDfaMarkStarts(editorRegex *regex, const char *text, 
+  ptrdiff_t len, ptrdiff_t from, unsigned char *starts) {
+  /* editorDfaFirstStart() that keeps every start it comes across: 
+     starts[i-from] gets set where a match starts at i
+  */
+  editorDfa *dfa = &regex->dfas[DFA_STARTS];
+  const unsigned char *t = (const unsigned char *)text;
+  int *next = dfa->next;
+  int state = editorDfaStart(regex, dfa, 1);
+  memset(starts, 0, len - from + 1);
+  starts[len - from] = (next[state] & DFA_ACCEPT) != 0;
+  ptrdiff_t i;
+  for (i=len-1; i>=from; i--) {
+    int to = next[state + 1 + regex->classes[t[i]]];
+    state = (to < 0) ? editorDfaTarget(regex, dfa, state, t[i], to) : to;
+    starts[i - from] = (next[state] & DFA_ACCEPT) != 0;
+    if (next[state] & DFA_DEAD) {
+      return;
+    }
+  }
+  if (i < 0 && (next[state] & DFA_ACCEPT_END)) {
+    starts[0] = 1;
+  }
+}
+
+ptrdiff_t editorDfaLongest(editorRegex *regex, const char *text, 
+  ptrdiff_t len, ptrdiff_t start) {
+  // where the longest match starting at start ends, -1 if none does
+  editorDfa *dfa = &regex->dfas[DFA_LONGEST];
+  const unsigned char *t = (const unsigned char *)text;
+  int *next = dfa->next;
+  int state = editorDfaStart(regex, dfa, start == 0);
+  ptrdiff_t end = (next[state] & DFA_ACCEPT) ? start : -1;
+  for (ptrdiff_t i=start; i<len; i++) {
+    int to = next[state + 1 + regex->classes[t[i]]];
+    state = (to < 0) ? editorDfaTarget(regex, dfa, state, t[i], to) : to;
+    if (next[state] & DFA_DEAD) {
+      return end;
+    }
+    if (next[state] & DFA_ACCEPT) {
+      end = i + 1;
+    }
+  }
+  return (next[state] & DFA_ACCEPT_END) ? len : end;
+}
+
+void editorRegexFree(editorRegex *regex) {
+  if (regex == NULL) {
+    return;
+  }
+  for (int k=0; k<3; k++) {
+    editorDfaFree(&regex->dfas[k]);
+  }
+  editorSearchFree(&regex->prefix);
+  editorSearchFree(&regex->required);
+  free(regex->nodes);
+  free(regex->sets);
+  free(regex->marks);
+  free(regex->stack);
+  free(regex->list);
+  free(regex->endlist);
+  free(regex);
+}
+
+editorRegex *editorRegexCompile(const char *pattern, int flags, 
+  char **literal, const char **error) {
+  /* a regex that only matches a fixed string doesn't need the DFAs,
+     that string comes back in literal & NULL gets returned. so does
+     NULL with the reason in error for an invalid pattern
+  */
+  editorRegex *regex = calloc(1, sizeof(editorRegex));
+  if (regex == NULL) {
+    die("calloc");
+  }
+  editorRegexParser parser = {pattern, flags, NULL, 0, 0, regex, NULL};
+  int root = editorRegexParseAlt(&parser);
+  if (root != -1 && *parser.p == ')') {
+    parser.error = "unmatched )";
+  }
+  *error = parser.error;
+  *literal = NULL;
+  if (parser.error == NULL) {
+    char prefix[CODIBLE_REGEX_PREFIX + 1];
+    int len = 0;
+    if (editorRegexPrefix(&parser, root, prefix, &len)) {
+      prefix[len] = '\0';
+      *literal = strdup(prefix);
+      if (*literal == NULL) {
+        die("strdup");
+      }
+    }
+    else {
+      int match = editorRegexAddNode(regex, RX_MATCH, -1, -1, -1);
+      int forward = editorRegexEmit(regex, parser.ast, root, match, 0);
+      match = editorRegexAddNode(regex, RX_MATCH, -1, -1, -1);
+      int reverse = editorRegexEmit(regex, parser.ast, root, match, 1);
+      if (forward == -1 || reverse == -1) {
+        *error = "regex too big";
+      }
+      else {
+        editorRegexClasses(regex);
+        editorDfaInit(regex, &regex->dfas[DFA_SEARCH], forward, 1);
+        editorDfaInit(regex, &regex->dfas[DFA_LONGEST], forward, 0);
+        editorDfaInit(regex, &regex->dfas[DFA_STARTS], reverse, 1);
+        regex->marks = editorMallocArray(regex->nodecount, sizeof(int));
+        memset(regex->marks, 0, sizeof(int)*regex->nodecount);
+        regex->stack = editorMallocArray(regex->nodecount*2 + 1, 
+          sizeof(int));
+        regex->list = editorMallocArray(regex->nodecount, sizeof(int));
+        regex->endlist = editorMallocArray(regex->nodecount, sizeof(int));
+        if (len > 0) {
+          prefix[len] = '\0';
+          regex->hasprefix = 1;
+          editorSearchCompile(&regex->prefix, prefix, 
+            flags & SEARCH_IGNORE_CASE);
+        }
+        char run[CODIBLE_REGEX_PREFIX], required[CODIBLE_REGEX_PREFIX + 1];
+        int runlen = 0, requiredlen = 0;
+        editorRegexRequired(&parser, root, run, &runlen, required, 
+          &requiredlen);
+        editorRegexEndRun(run, &runlen, required, &requiredlen);
+        if (requiredlen > len) {
+          required[requiredlen] = '\0';
+          regex->hasrequired = 1;
+          editorSearchCompile(&regex->required, required, 
+            flags & SEARCH_IGNORE_CASE);
+        }
+      }
+    }
+  }
+  free(parser.ast);
+  if (*error || *literal) {
+    free(regex->nodes);
+    free(regex->sets);
+    free(regex);
+    return NULL;
+  }
+  return regex;
+}
+
+ptrdiff_t editorRegexForward(editorSearch *search, const char *text, 
+  ptrdiff_t len, ptrdiff_t from) {
+  /* the leftmost match starting at from or after it. the forward 
+     DFA tells if there is one at all, the backward one where it 
+     starts
+  */
+  editorRegex *regex = search->regex;
+  if (from > len) {
+    return -1;
+  }
+  // a row without the string every match needs has none at all
+  if (regex->hasrequired && 
+    editorSearchForward(&regex->required, text, len, from) == -1) {
+    return -1;
+  }
+  if (editorDfaSearch(regex, text, len, from) == -1) {
+    return -1;
+  }
+  ptrdiff_t start = editorDfaFirstStart(regex, text, len, from);
+  if (start == -1) {
+    return -1;
+  }
+  if (!(search->flags & SEARCH_WHOLE_WORD) || editorSearchWholeWord(
+    text, len, start, editorDfaLongest(regex, text, len, start))) {
+    return start;
+  }
+  // the candidates after one that's part of a longer word
+  return editorRegexStarts(search, text, len, start + 1, 0, NULL);
+}
+
+ptrdiff_t editorRegexStarts(editorSearch *search, const char *text, 
+  ptrdiff_t len, ptrdiff_t from, ptrdiff_t filerow, 
+  editorSearchResults *results) {
+  /* the matches starting at from or after it, found by one backward
+     pass that marks where they all start. editorRegexForward() reads
+     the rest of the row once per match, which adds up on long rows.
+     adds them all to results & returns how many there are, or with
+     NULL results where the first one starts, -1 if none does
+  */
+  editorRegex *regex = search->regex;
+  unsigned char *starts = editorMallocArray(len - from + 1, 1);
+  editorDfaMarkStarts(regex, text, len, from, starts);
+  ptrdiff_t added = 0;
+  ptrdiff_t i = from;
+  while (i <= len) {
+    unsigned char *start = memchr(&starts[i - from], 1, len - i + 1);
+    if (start == NULL) {
+      break;
+    }
+    i = from + (start - starts);
+    ptrdiff_t end = editorDfaLongest(regex, text, len, i);
+    if ((search->flags & SEARCH_WHOLE_WORD) && 
+      !editorSearchWholeWord(text, len, i, end)) {
+      i++;
+      continue;
+    }
+    if (results == NULL) {
+      free(starts);
+      return i;
+    }
+    editorResultsAdd(results, filerow, i);
+    added++;
+    i = (end > i) ? end : i + 1;
+  }
+  free(starts);
+  return results ? added : -1;
+}
+
+/*** trigram index ***/
+
+unsigned int editorTrigramHash(unsigned int key) {
+  key ^= key >> 13;
+  key *= 0x5bd1e995;
+  return key ^ (key >> 15);
+}
+
+editorTrigram *editorIndexFind(editorIndex *index, unsigned int key, 
+  int create) {
+  /* the list of a trigram, a new empty one if create is set & the
+     trigram has none yet
+  */
+  key++;
+  if (create && (index->trigrams + 1)*2 > index->tablesize) {
+    // growing the table before it gets half full
+    editorTrigram *old = index->table;
+    int oldsize = index->tablesize;
+    index->tablesize *= 2;
+    index->table = editorMallocArray(index->tablesize, 
+      sizeof(editorTrigram));
+    memset(index->table, 0, sizeof(editorTrigram)*index->tablesize);
+    for (int k=0; k<oldsize; k++) {
+      if (old[k].key) {
+        unsigned int slot = editorTrigramHash(old[k].key);
+        while (index->table[slot & (index->tablesize - 1)].key) {
+          slot++;
+        }
+        index->table[slot & (index->tablesize - 1)] = old[k];
+      }
+    }
+    free(old);
+  }
+  unsigned int mask = index->tablesize - 1;
+  unsigned int slot = editorTrigramHash(key) & mask;
+  while (index->table[slot].key != 0) {
+    if (index->table[slot].key == key) {
+      return &index->table[slot];
+    }
+    slot = (slot + 1) & mask;
+  }
+  if (!create) {
+    return NULL;
+  }
+  editorTrigram *trigram = &index->table[slot];
+  trigram->key = key;
+  trigram->last = -1;
+  index->trigrams++;
+  return trigram;
+}
+
+void editorTrigramAppend(editorTrigram *trigram, int id) {
+  // a row that has the trigram more than once gets listed once
+  if (trigram->last == id || trigram->count == -1) {
+    return;
+  }
+  if (trigram->count > CODIBLE_INDEX_DENSE && trigram->count*4 > id) {
+    free(trigram->ids);
+    trigram->ids = NULL;
+    trigram->len = trigram->cap = 0;
+    trigram->count = -1;
+    return;
+  }
+  if (trigram->len + 5 > trigram->cap) {
+    trigram->cap = trigram->cap ? trigram->cap*2 : 8;
+    trigram->ids = editorReallocArray(trigram->ids, trigram->cap, 1);
+  }
+  unsigned int delta = id - trigram->last;
+  while (delta >= 0x80) {
+    trigram->ids[trigram->len++] = (delta & 0x7F) | 0x80;
+    delta >>= 7;
+  }
+  trigram->ids[trigram->len++] = delta;
+  trigram->last = id;
+  trigram->count++;
+}
+
+int editorTrigramNext(editorTrigram *trigram, ptrdiff_t *at, int id) {
+  // the id after id in the list, reading it from ids[*at] on
+  unsigned int delta = 0;
+  int shift = 0;
+  unsigned char byte;
+  do {
+    byte = trigram->ids[(*at)++];
+    delta |= (unsigned int)(byte & 0x7F) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  return id + delta;
+}
+
+void editorIndexAddRow(editorIndex *index, erow *row) {
+  // giving a row a new id & listing it under each of its trigrams
+  if (row->id != -1) {
+    index->rows[row->id] = -1;
+  }
+  if (index->ids == index->idcap) {
+    index->idcap = index->idcap ? index->idcap*2 : 1024;
+    index->rows = editorReallocArray(index->rows, index->idcap, 
+      sizeof(ptrdiff_t));
+  }
+  row->id = index->ids++;
+  index->rows[row->id] = row->index;
+  if (row->size >= CODIBLE_LONG_LINE) {
+    editorTrigramAppend(&index->longrows, row->id);
+    return;
+  }
+  unsigned int key = 0;
+  for (ptrdiff_t j=0; j<row->size; j++) {
+    key = ((key << 8) | editorFoldCase((unsigned char)row->chars[j])) & 
+      0xFFFFFF;
+    if (j >= 2) {
+      editorTrigramAppend(editorIndexFind(index, key, 1), row->id);
+    }
+  }
+}
+
+void editorIndexClear(editorIndex *index) {
+  // forgetting every row, so that building starts over
+  for (int k=0; k<index->tablesize; k++) {
+    free(index->table[k].ids);
+  }
+  free(index->table);
+  free(index->longrows.ids);
+  index->tablesize = 1024;
+  index->table = editorMallocArray(index->tablesize, 
+    sizeof(editorTrigram));
+  memset(index->table, 0, sizeof(editorTrigram)*index->tablesize);
+  index->trigrams = 0;
+  memset(&index->longrows, 0, sizeof(editorTrigram));
+  index->longrows.last = -1;
+  index->ids = 0;
+  index->built = 0;
+  for (ptrdiff_t j=0; j<E.numrows; j++) {
+    E.row[j].id = -1;
+  }
+}
+
+void editorIndexToggle() {
+  if (E.index) {
+    editorIndexClear(E.index);
+    free(E.index->table);
+    free(E.index->rows);
+    free(E.index);
+    E.index = NULL;
+    editorSetStatusMessage("Trigram index off");
+    return;
+  }
+  E.index = calloc(1, sizeof(editorIndex));
+  if (E.index == NULL) {
+    die("calloc");
+  }
+  editorIndexClear(E.index);
+  E.index->announce = 1;
+  editorSetStatusMessage("Trigram index: building");
+}
+
+void editorIndexUpdateRow(erow *row) {
+  // a row that's indexed already gets indexed again as it changes
+  editorIndex *index = E.index;
+  if (index == NULL || row->index >= index->built) {
+    return;
+  }
+  /* the ids rows left behind take memory & reading time in the 
+     lists, once they are most of them it's built again from scratch
+  */
+  if (index->ids > 2*E.numrows + CODIBLE_INDEX_SLACK) {
+    editorIndexClear(index);
+    return;
+  }
+  editorIndexAddRow(index, row);
+}
+
+void editorIndexMoveRows(ptrdiff_t at, ptrdiff_t inserted, int removedid) {
+  /* a row got inserted at at, or the one at at got deleted. the 
+     rows after it moved, & building has one more or one less row
+     left behind it
+  */
+  editorIndex *index = E.index;
+  if (index == NULL) {
+    return;
+  }
+  if (removedid != -1) {
+    index->rows[removedid] = -1;
+  }
+  if (at < index->built) {
+    index->built += inserted ? 1 : -1;
+  }
+  for (ptrdiff_t j=at+inserted; j<E.numrows; j++) {
+    if (E.row[j].id != -1) {
+      index->rows[E.row[j].id] = j;
+    }
+  }
+}
+
+int editorIndexIdle(long long deadline) {
+  /* building the index while no key is waiting, rows at a time 
+     until the deadline
+  */
+  editorIndex *index = E.index;
+  if (index == NULL || index->built == E.numrows) {
+    return 0;
+  }
+  /* ids are ints & a row can use up two of them before everything
+     gets indexed again, a file with more rows is searched without
+     the index
+  */
+  if (E.numrows > INT_MAX/4) {
+    if (index->announce) {
+      editorSetStatusMessage("Trigram index: too many rows");
+      index->announce = 0;
+    }
+    return 0;
+  }
+  long long start = editorMicroseconds(), now;
+  do {
+    editorIndexAddRow(index, &E.row[index->built++]);
+    now = editorMicroseconds();
+  } while (index->built < E.numrows && now < deadline);
+  index->buildtime += (now - start)/1e6;
+  if (index->built == E.numrows) {
+    // the lists stop growing much, they don't need room to spare
+    for (int k=0; k<index->tablesize; k++) {
+      editorTrigram *trigram = &index->table[k];
+      if (trigram->cap > trigram->len + 5) {
+        trigram->cap = trigram->len + 5;
+        trigram->ids = editorReallocArray(trigram->ids, trigram->cap, 1);
+      }
+    }
+  }
+  if (index->built == E.numrows && index->announce) {
+    // what the index costs next to the text it covers
+    size_t bytes = sizeof(editorIndex) + 
+      sizeof(editorTrigram)*index->tablesize + 
+      sizeof(ptrdiff_t)*index->idcap + index->longrows.cap;
+    for (int k=0; k<index->tablesize; k++) {
+      bytes += index->table[k].cap;
+    }
+    size_t text = 0;
+    for (ptrdiff_t j=0; j<E.numrows; j++) {
+      text += E.row[j].size + 1;
+    }
+    editorSetStatusMessage("Trigram index: %d trigrams, %.1f MB "
+      "(%.0f%% of the text), %.1f s", index->trigrams, bytes/1048576.0, 
+      text ? 100.0*bytes/text : 0.0, index->buildtime);
+    index->announce = 0;
+  }
+  return 1;
+}
+
+int editorIndexCompareRows(const void *a, const void *b) {
+  ptrdiff_t x = *(const ptrdiff_t *)a, y = *(const ptrdiff_t *)b;
+  return (x > y) - (x < y);
+}
+
+int editorIndexCollect(editorSearch *search, 
+  editorSearchResults *results) {
+
+  /* editorSearchCollect() on just the rows that have every trigram
+     of the query. returns -1 when the index can't tell which rows
+     those are: it's not built, or the query has no string of three
+     bytes every match contains. or when they're so many that 
+     searching every row is quicker
+  */
+  editorIndex *index = E.index;
+  editorSearch *literal = search;
+  if (search->regex) {
+    literal = search->regex->hasrequired ? &search->regex->required : 
+      search->regex->hasprefix ? &search->regex->prefix : NULL;
+  }
+  if (index == NULL || index->built < E.numrows || literal == NULL || 
+    literal->len < 3) {
+    return -1;
+  }
+  // the lists of the trigrams of the query, shortest first
+  editorTrigram **lists = editorMallocArray(literal->len, 
+    sizeof(editorTrigram *));
+  int listcount = 0, missing = 0;
+  unsigned int key = 0;
+  for (ptrdiff_t j=0; j<literal->len && !missing; j++) {
+    key = ((key << 8) | 
+      editorFoldCase((unsigned char)literal->query[j])) & 0xFFFFFF;
+    if (j >= 2) {
+      editorTrigram *trigram = editorIndexFind(index, key, 0);
+      missing = (trigram == NULL);
+      if (!missing && trigram->count == -1) {
+        // it's in most rows anyway
+        continue;
+      }
+      int k = listcount;
+      while (!missing && k > 0 && lists[k-1]->count > trigram->count) {
+        lists[k] = lists[k-1];
+        k--;
+      }
+      if (!missing) {
+        lists[k] = trigram;
+        listcount++;
+      }
+    }
+  }
+  if (!missing && (listcount == 0 || lists[0]->count*4 > E.numrows)) {
+    free(lists);
+    return -1;
+  }
+  /* holding ids first & then the rows they lead to, so it's as wide
+     as a row number
+  */
+  ptrdiff_t *ids = NULL;
+  ptrdiff_t count = 0;
+  if (!missing) {
+    ids = editorMallocArray(lists[0]->count + index->longrows.count, 
+      sizeof(ptrdiff_t));
+    ptrdiff_t at = 0;
+    int id = -1;
+    while (at < lists[0]->len) {
+      id = editorTrigramNext(lists[0], &at, id);
+      ids[count++] = id;
+    }
+    // keeping the ids the next lists have too
+    for (int k=1; k<listcount && count > 0; k++) {
+      if (lists[k]->count > count*CODIBLE_INDEX_INTERSECT) {
+        break;
+      }
+      ptrdiff_t kept = 0;
+      at = 0;
+      id = -1;
+      for (ptrdiff_t c=0; c<count; c++) {
+        while (id < ids[c] && at < lists[k]->len) {
+          id = editorTrigramNext(lists[k], &at, id);
+        }
+        if (id == ids[c]) {
+          ids[kept++] = id;
+        }
+      }
+      count = kept;
+    }
+  }
+  else {
+    ids = editorMallocArray(index->longrows.count + 1, sizeof(ptrdiff_t));
+  }
+  ptrdiff_t at = 0;
+  int id = -1;
+  while (at < index->longrows.len) {
+    id = editorTrigramNext(&index->longrows, &at, id);
+    ids[count++] = id;
+  }
+  free(lists);
+  // the rows of the ids that still lead somewhere, in file order
+  ptrdiff_t rowcount = 0;
+  int sorted = 1;
+  for (ptrdiff_t k=0; k<count; k++) {
+    ptrdiff_t row = index->rows[ids[k]];
+    if (row != -1) {
+      sorted = sorted && (rowcount == 0 || ids[rowcount-1] < row);
+      ids[rowcount++] = row;
+    }
+  }
+  if (!sorted) {
+    qsort(ids, rowcount, sizeof(ptrdiff_t), editorIndexCompareRows);
+  }
+  results->count = 0;
+  int status = 1;
+  for (ptrdiff_t k=0; k<rowcount && status; k++) {
+    editorSearchCollectRow(search, ids[k], results);
+    if (results->count > CODIBLE_SEARCH_RESULTS) {
+      results->count = 0;
+      status = 0;
+    }
+  }
+  free(ids);
+  return status;
+}
+
+/*** search workers ***/
+
+int editorSearchHasChunk() {
+  /* the workers hand out the chunks nearest first, & none beyond
+     the nearest one that already has a match
+  */
+  editorSearchPool *pool = &search_pool;
+  return !atomic_load(&pool->cancelled) && 
+    pool->nextchunk < pool->chunkcount && 
+    pool->nextchunk <= atomic_load(&pool->best);
+}
+
+void *editorSearchWorker(void *arg) {
+  (void)arg;
+  editorSearchPool *pool = &search_pool;
+  /* the DFAs of a regex grow while they read, so every worker 
+     searches with a copy of its own
+  */
+  editorSearch search = {0};
+  pthread_mutex_lock(&pool->lock);
+  while (1) {
+    while (!editorSearchHasChunk()) {
+      pthread_cond_wait(&pool->work, &pool->lock);
+    }
+    ptrdiff_t chunk = pool->nextchunk++;
+    pool->busy++;
+    codibleSelect(pool->editor);
+    pthread_mutex_unlock(&pool->lock);
+
+    if (search.pattern == NULL || search.flags != pool->search->flags || 
+      strcmp(search.pattern, pool->search->pattern) != 0) {
+      editorSearchCompile(&search, pool->search->pattern, 
+        pool->search->flags);
+    }
+    ptrdiff_t first = chunk*CODIBLE_SEARCH_CHUNK;
+    ptrdiff_t last = first + CODIBLE_SEARCH_CHUNK;
+    ptrdiff_t row = 0, at = -1;
+    if (pool->collect) {
+      // the rows in order, until there are too many matches
+      if (last > pool->numrows) {
+        last = pool->numrows;
+      }
+      for (ptrdiff_t r=first; r<last && !atomic_load(&pool->cancelled); 
+        r++) {
+        ptrdiff_t added = editorSearchCollectRow(&search, r, 
+          &pool->chunkresults[chunk]);
+        if (atomic_fetch_add(&pool->found, added) + added > 
+          CODIBLE_SEARCH_RESULTS) {
+          atomic_store(&pool->cancelled, 1);
+        }
+      }
+    }
+    else {
+      if (last > pool->numrows + 1) {
+        last = pool->numrows + 1;
+      }
+      for (ptrdiff_t step=first; step<last && at==-1; step++) {
+        // a nearer chunk has a match, or the search is over
+        if (atomic_load(&pool->cancelled) || 
+          atomic_load(&pool->best) < chunk) {
+          break;
+        }
+        at = editorSearchStep(&search, pool->filerow, pool->cx, 
+          pool->direction, step, &row);
+      }
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (at != -1 && chunk < atomic_load(&pool->best)) {
+      atomic_store(&pool->best, chunk);
+      pool->matchrow = row;
+      pool->matchcx = at;
+    }
+    pool->busy--;
+    if (pool->busy == 0) {
+      pthread_cond_broadcast(&pool->idle);
+      /* every chunk before the nearest match is searched, or all
+         of them are
+      */
+      if (!pool->finished && !editorSearchHasChunk()) {
+        pool->finished = 1;
+        write(pool->wakeup[1], "", 1);
+      }
+    }
+  }
+  return NULL;
+}
+
+int editorSearchPoolStart() {
+  /* taking the workers for a job, starting them the first time a 
+     big file gets searched. they're held until editorSearchPoolEnd()
+     unless 0 gets returned
+  */
+  editorSearchPool *pool = &search_pool;
+  pthread_mutex_lock(&pool->jobs);
+  if (pool->threadcount) {
+    return 1;
+  }
+  if (pipe(pool->wakeup) == -1) {
+    pthread_mutex_unlock(&pool->jobs);
+    return 0;
+  }
+  fcntl(pool->wakeup[0], F_SETFL, O_NONBLOCK);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work, NULL);
+  pthread_cond_init(&pool->idle, NULL);
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  if (count < 1) {
+    count = 1;
+  }
+  if (count > CODIBLE_SEARCH_THREADS) {
+    count = CODIBLE_SEARCH_THREADS;
+  }
+  // resize signals are for the editor, not for the workers
+  sigset_t blocked, previous;
+  sigemptyset(&blocked);
+  sigaddset(&blocked, SIGWINCH);
+  pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+  for (int i=0; i<count; i++) {
+    if (pthread_create(&pool->threads[pool->threadcount], NULL, 
+      editorSearchWorker, NULL) == 0) {
+      pool->threadcount++;
+    }
+  }
+  pthread_sigmask(SIG_SETMASK, &previous, NULL);
+  if (pool->threadcount == 0) {
+    pthread_mutex_unlock(&pool->jobs);
+    return 0;
+  }
+  return 1;
+}
+
+void editorSearchPoolEnd() {
+  // another editor's job can have the workers now
+  pthread_mutex_unlock(&search_pool.jobs);
+}
+
+int editorSearchPoolRun(editorSearch *search, int collect, 
+  ptrdiff_t filerow, ptrdiff_t cx, int direction) {
+  /* handing a job to the workers & waiting for them while still 
+     following resizes. a key pressed meanwhile cancels the job & 
+     -1 gets returned so that the key gets read
+  */
+  editorSearchPool *pool = &search_pool;
+  pthread_mutex_lock(&pool->lock);
+  pool->editor = codible_editor;
+  pool->search = search;
+  pool->collect = collect;
+  pool->filerow = filerow;
+  pool->cx = cx;
+  pool->direction = direction;
+  pool->numrows = E.numrows;
+  pool->chunkcount = (E.numrows + (collect ? CODIBLE_SEARCH_CHUNK - 1 : 
+    CODIBLE_SEARCH_CHUNK)) / CODIBLE_SEARCH_CHUNK;
+  if (collect) {
+    pool->chunkresults = calloc(pool->chunkcount, 
+      sizeof(editorSearchResults));
+    if (pool->chunkresults == NULL) {
+      die("calloc");
+    }
+  }
+  pool->nextchunk = 0;
+  pool->finished = 0;
+  atomic_store(&pool->best, pool->chunkcount);
+  atomic_store(&pool->found, 0);
+  atomic_store(&pool->cancelled, 0);
+  pthread_cond_broadcast(&pool->work);
+  pthread_mutex_unlock(&pool->lock);
+
+  struct pollfd fds[2] = {
+    {E.input, POLLIN, 0},
+    {pool->wakeup[0], POLLIN, 0}
+  };
+  int result = 0, drawn = 0;
+  while (1) {
+    int ready = poll(fds, 2, CODIBLE_RESIZE_QUIET);
+    if (ready == -1 && errno != EINTR) {
+      die("poll");
+    }
+    if (ready == 0 && !drawn) {
+      // a slow search shows the prompt with the key that started it
+      editorHookRefresh();
+      drawn = 1;
+    }
+    if (ready > 0 && (fds[1].revents & POLLIN)) {
+      break;
+    }
+    if (ready > 0 && (fds[0].revents & POLLIN)) {
+      atomic_store(&pool->cancelled, 1);
+      result = -1;
+      break;
+    }
+    editorHookIdle();
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->busy) {
+    pthread_cond_wait(&pool->idle, &pool->lock);
+  }
+  // no chunk is left to take until the next job
+  atomic_store(&pool->cancelled, 1);
+  char byte;
+  while (read(pool->wakeup[0], &byte, 1) == 1) {
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return result;
+}
+
+int editorSearchParallel(editorSearch *search, ptrdiff_t filerow, 
+  ptrdiff_t cx, int direction, ptrdiff_t *matchrow, ptrdiff_t *matchcx) {
+  /* editorSearchRows() on the workers, returning -1 if a key 
+     cancelled it
+  */
+  if (E.numrows < CODIBLE_SEARCH_CHUNK || !editorSearchPoolStart()) {
+    return editorSearchRows(search, filerow, cx, direction, 
+      matchrow, matchcx);
+  }
+  editorSearchPool *pool = &search_pool;
+  int found = editorSearchPoolRun(search, 0, filerow, cx, direction);
+  if (found == 0 && atomic_load(&pool->best) < pool->chunkcount) {
+    *matchrow = pool->matchrow;
+    *matchcx = pool->matchcx;
+    found = 1;
+  }
+  editorSearchPoolEnd();
+  return found;
+}
+
+int editorSearchCollect(editorSearch *search, 
+  editorSearchResults *results) {
+  /* gathering every match of the file into results. returns 0 if 
+     there are more than CODIBLE_SEARCH_RESULTS, which then aren't 
+     kept, & -1 if a key cancelled it
+  */
+  // the trigram index narrows the rows down when it's built
+  int indexed = editorIndexCollect(search, results);
+  if (indexed != -1) {
+    return indexed;
+  }
+  results->count = 0;
+  if (E.numrows < CODIBLE_SEARCH_CHUNK || !editorSearchPoolStart()) {
+    for (ptrdiff_t r=0; r<E.numrows; r++) {
+      editorSearchCollectRow(search, r, results);
+      if (results->count > CODIBLE_SEARCH_RESULTS) {
+        results->count = 0;
+        return 0;
+      }
+    }
+    return 1;
+  }
+  editorSearchPool *pool = &search_pool;
+  int status = editorSearchPoolRun(search, 1, 0, 0, 1);
+  if (status == 0) {
+    status = (atomic_load(&pool->found) <= CODIBLE_SEARCH_RESULTS);
+  }
+  // the chunks hold the rows in order, so their matches are too
+  for (ptrdiff_t k=0; k<pool->chunkcount; k++) {
+    editorSearchResults *chunk = &pool->chunkresults[k];
+    if (status == 1 && chunk->count) {
+      if (results->count + chunk->count > results->cap) {
+        results->cap = results->count + chunk->count;
+        results->matches = editorReallocArray(results->matches, 
+          results->cap, sizeof(editorSearchMatch));
+      }
+
+      memcpy(&results->matches[results->count], chunk->matches, 
+        sizeof(editorSearchMatch)*chunk->count);
+      results->count += chunk->count;
+    }
+    editorResultsFree(chunk);
+  }
+  free(pool->chunkresults);
+  pool->chunkresults = NULL;
+  editorSearchPoolEnd();
+  return status;
+}
+
+/*** find ***/
+
+void editorFindStart(editorSearch *search, 
+  editorSearchResults *results, int complete) {
+  /* the query or its modes changed: the matches on the screen are 
+     the new ones, & counting them starts over unless results has 
+     all of them already
+  */
+  editorFindState *find = &E.find;
+  find->search = search;
+  find->matchrow = -1;
+  find->position = 0;
+  find->results = results;
+  find->complete = complete;
+  ptrdiff_t chunks = E.numrows/CODIBLE_SEARCH_CHUNK + 1;
+  if (chunks > find->chunkcap) {
+    find->chunkcap = chunks;
+    find->chunkcounts = editorReallocArray(find->chunkcounts, chunks, 
+      sizeof(ptrdiff_t));
+  }
+  memset(find->chunkcounts, 0, sizeof(ptrdiff_t)*chunks);
+  find->counted = complete ? E.numrows : 0;
+  find->total = complete ? results->count : 0;
+}
+
+void editorFindStop() {
+  // the prompt closed, the screen goes back to the plain text
+  editorFindState *find = &E.find;
+  find->search = NULL;
+  find->results = NULL;
+  free(find->chunkcounts);
+  find->chunkcounts = NULL;
+  find->chunkcap = 0;
+  editorResultsFree(&find->scratch);
+}
+
+int editorFindIdle(long long deadline) {
+  /* counting the matches of the find prompt while no key is 
+     waiting, rows at a time until the deadline like the trigram 
+     index gets built. the count shows up as it goes
+  */
+  editorFindState *find = &E.find;
+  if (find->search == NULL || find->counted >= E.numrows) {
+    return 0;
+  }
+  // rows a grep adds meanwhile get counted too
+  ptrdiff_t chunks = E.numrows/CODIBLE_SEARCH_CHUNK + 1;
+  if (chunks > find->chunkcap) {
+    find->chunkcounts = editorReallocArray(find->chunkcounts, chunks, 
+      sizeof(ptrdiff_t));
+    memset(&find->chunkcounts[find->chunkcap], 0, 
+      sizeof(ptrdiff_t)*(chunks - find->chunkcap));
+    find->chunkcap = chunks;
+  }
+  do {
+    ptrdiff_t r = find->counted++;
+    ptrdiff_t added = editorSearchCollectRow(find->search, r, 
+      &find->scratch);
+    find->scratch.count = 0;
+    find->chunkcounts[r/CODIBLE_SEARCH_CHUNK] += added;
+    find->total += added;
+  } while (find->counted < E.numrows && editorMicroseconds() < deadline);
+  return 1;
+}
+
+ptrdiff_t editorFindPosition() {
+  /* the number of the current match among all of them, 0 while 
+     the rows before it aren't all counted yet
+  */
+  editorFindState *find = &E.find;
+  if (find->matchrow == -1 || find->position) {
+    return find->position;
+  }
+  editorSearchResults *results = find->results;
+  if (find->complete) {
+    // the first match that doesn't come before the current one
+    ptrdiff_t low = 0, high = results->count;
+    while (low < high) {
+      ptrdiff_t middle = low + (high - low)/2;
+      editorSearchMatch *match = &results->matches[middle];
+      if (match->row < find->matchrow || (match->row == find->matchrow
+        && match->cx < find->matchcx)) {
+        low = middle + 1;
+      }
+      else {
+        high = middle;
+      }
+    }
+    find->position = low + 1;
+    return find->position;
+  }
+  // the chunks before the one it's in, then the rows before it there
+  ptrdiff_t chunk = find->matchrow/CODIBLE_SEARCH_CHUNK;
+  ptrdiff_t first = chunk*CODIBLE_SEARCH_CHUNK;
+  if (find->counted <= find->matchrow) {
+    return 0;
+  }
+  ptrdiff_t position = 1;
+  for (ptrdiff_t k=0; k<chunk; k++) {
+    position += find->chunkcounts[k];
+  }
+  for (ptrdiff_t r=first; r<=find->matchrow; r++) {
+    editorSearchCollectRow(find->search, r, &find->scratch);
+  }
+  for (ptrdiff_t k=0; k<find->scratch.count; k++) {
+    editorSearchMatch *match = &find->scratch.matches[k];
+    if (match->row < find->matchrow || match->cx < find->matchcx) {
+      position++;
+    }
+  }
+  find->scratch.count = 0;
+  find->position = position;
+  return position;
+}
+
+int editorFindCounter(char *buf, int size) {
+  /* "n of N" for the status bar while the find prompt is open, a 
+     count that's still going gets a '+'. returns its length
+  */
+  editorFindState *find = &E.find;
+  if (find->search == NULL) {
+    return 0;
+  }
+  const char *more = (find->counted < E.numrows) ? "+" : "";
+  ptrdiff_t position = editorFindPosition();
+  if (position) {
+    return snprintf(buf, size, "%td of %td%s | ", position, find->total, 
+      more);
+  }
+  return snprintf(buf, size, "%td%s matches | ", find->total, more);
+}
+
+unsigned char *editorFindHighlight(erow *row) {
+  /* a copy of the highlights of a row with the matches of the find
+     prompt marked in it, NULL if it has none. a long row only gets
+     searched around the window of it that's rendered
+  */
+  editorFindState *find = &E.find;
+  if (find->search == NULL || row->rsize == 0) {
+    return NULL;
+  }
+  ptrdiff_t from = 0, len = row->size;
+  if (row->checkpointcount) {
+    from = row->cwin - CODIBLE_LONG_LINE_MARGIN;
+    len = row->cwinend + CODIBLE_LONG_LINE_MARGIN;
+    if (from < 0) {
+      from = 0;
+    }
+    if (len > row->size) {
+      len = row->size;
+    }
+  }
+  editorSearchResults *matches = &find->scratch;
+  matches->count = 0;
+  if (editorSearchCollectRange(find->search, row->index, from, len, 
+    matches) == 0) {
+    return NULL;
+  }
+  unsigned char *highlight = editorMallocArray(row->rsize, 1);
+  memcpy(highlight, row->highlight, row->rsize);
+  ptrdiff_t rbase = editorRowCxToRb(row, row->cwin);
+  for (ptrdiff_t k=0; k<matches->count; k++) {
+    ptrdiff_t start = matches->matches[k].cx;
+    ptrdiff_t end = editorSearchMatchEnd(find->search, row->chars, len, 
+      start);
+    // only the part of it that's rendered
+    if (start < row->cwin) {
+      start = row->cwin;
+    }
+    if (end > row->cwinend) {
+      end = row->cwinend;
+    }
+    if (start >= end) {
+      continue;
+    }
+    int current = (row->index == find->matchrow && 
+      matches->matches[k].cx == find->matchcx);
+    start = editorRowCxToRb(row, start) - rbase;
+    end = editorRowCxToRb(row, end) - rbase;
+    memset(&highlight[start], current ? HL_MATCH_CURRENT : HL_MATCH, 
+      end - start);
+  }
+  matches->count = 0;
+  return highlight;
+}
+
+ptrdiff_t editorRowReplace(editorSearch *search, erow *row, 
+  editorSearchMatch *matches, ptrdiff_t count, const char *with, 
+  ptrdiff_t withlen) {
+  /* building the new contents of a row in one pass over it, the 
+     text between the matches & the replacement for each of them.
+     the row is rendered & highlighted once, after all of them. a
+     match starting inside the one before it is left alone, returns
+     how many got replaced
+  */
+  if (withlen && count > (PTRDIFF_MAX - row->size - 1)/withlen) {
+    errno = ENOMEM;
+    die("malloc");
+  }
+  char *chars = editorMallocArray(row->size + count*withlen + 1, 1);
+  ptrdiff_t len = 0, from = 0, replaced = 0;
+  for (ptrdiff_t k=0; k<count; k++) {
+    ptrdiff_t at = matches[k].cx;
+    if (at < from) {
+      continue;
+    }
+    ptrdiff_t end = editorSearchMatchEnd(search, row->chars, row->size, 
+      at);
+    replaced++;
+    memcpy(&chars[len], &row->chars[from], at - from);
+    len += at - from;
+    memcpy(&chars[len], with, withlen);
+    len += withlen;
+    from = end;
+  }
+  memcpy(&chars[len], &row->chars[from], row->size - from);
+  len += row->size - from;
+  chars[len] = '\0';
+  editorRowFree(MEMORY_CHARS, row->chars);
+  row->chars = chars;
+  editorMemoryAdd(MEMORY_CHARS, chars);
+  row->size = len;
+  editorUpdateRow(row);
+  E.dirty++;
+  return replaced;
+}
+
+ptrdiff_t editorReplaceAll(editorSearch *search, const char *with, 
+  ptrdiff_t *rows) {
+  /* replacing every match of a compiled query in the file, returns
+     how many there were & sets rows to the rows they were on
+  */
+  /* the rows with a match are known without reading the others 
+     when the matches fit in a list, the trigram index helps there.
+     otherwise every row gets searched on its own
+  */
+  editorSearchResults results = {0};
+  int complete = (editorSearchCollect(search, &results) == 1);
+  editorSearchResults row_matches = {0};
+  ptrdiff_t withlen = strlen(with);
+  ptrdiff_t replaced = 0;
+  ptrdiff_t k = 0, r = 0;
+  *rows = 0;
+  while (1) {
+    editorSearchMatch *matches;
+    ptrdiff_t count;
+    if (complete) {
+      if (k == results.count) {
+        break;
+      }
+      r = results.matches[k].row;
+      matches = &results.matches[k];
+      for (count=0; k<results.count && results.matches[k].row == r; 
+        k++) {
+        count++;
+      }
+    }
+    else {
+      if (r == E.numrows) {
+        break;
+      }
+      row_matches.count = 0;
+      count = editorSearchCollectRow(search, r, &row_matches);
+      matches = row_matches.matches;
+    }
+    if (count) {
+      replaced += editorRowReplace(search, &E.row[r], matches, count, 
+        with, withlen);
+      (*rows)++;
+    }
+    if (!complete) {
+      r++;
+    }
+  }
+  // the cursor stays on its row, inside of it
+  if (E.cy < E.numrows && E.cx > E.row[E.cy].size) {
+    E.cx = E.row[E.cy].size;
+  }
+  editorResultsFree(&results);
+  editorResultsFree(&row_matches);
+  return replaced;
+}
+
+/*** append buffer ***/
+
+void abAppend(struct abuf *ab, const char *s, size_t len) {
+  // a sum past PTRDIFF_MAX comes out negative & is fatal there
+  char *new = editorReallocArray(ab->b, (ptrdiff_t)(ab->len + len), 1);
+  memcpy(&new[ab->len],s,len); 
+  // copy the string s at the end of the buffer
+  // updating pointer and length
+  ab->b = new;
+  ab->len += len;
+}
+
+void abFree(struct abuf *ab) {
+  free(ab->b);
+}
+
+/*** grep ***/
+
+void editorGrepPush(editorGrep *grep, char **paths, int count) {
+  // adding paths for the workers to take, with the lock held
+  if (grep->pathcount + count > grep->pathcap) {
+    grep->pathcap = (grep->pathcount + count)*2;
+    grep->paths = editorReallocArray(grep->paths, grep->pathcap, 
+      sizeof(char *));
+  }
+  memcpy(&grep->paths[grep->pathcount], paths, sizeof(char *)*count);
+  grep->pathcount += count;
+  pthread_cond_broadcast(&grep->work);
+}
+
+void editorGrepDirectory(editorGrep *grep, const char *path) {
+  /* handing what a directory holds to the workers, all at once. 
+     hidden files & directories are left out, symbolic links too so
+     a loop of them can't keep a grep going. directories get a '/'
+     at the end, so they're known without looking again
+  */
+  // the working directory is the empty path
+  DIR *dir = opendir(path[0] ? path : ".");
+  if (dir == NULL) {
+    return;
+  }
+  char **found = NULL;
+  int count = 0, cap = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    size_t len = strlen(path) + strlen(entry->d_name) + 2;
+    char *child = editorMallocArray(len, 1);
+    snprintf(child, len, "%s%s", path, entry->d_name);
+    int type = entry->d_type;
+    if (type == DT_UNKNOWN) {
+      struct stat st;
+      type = (lstat(child, &st) == -1) ? DT_UNKNOWN : 
+        S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : 
+        DT_UNKNOWN;
+    }
+    if (type != DT_DIR && type != DT_REG) {
+      free(child);
+      continue;
+    }
+    if (type == DT_DIR) {
+      strcat(child, "/");
+    }
+    if (count == cap) {
+      cap = cap ? cap*2 : 64;
+      found = editorReallocArray(found, cap, sizeof(char *));
+    }
+    found[count++] = child;
+  }
+  closedir(dir);
+  if (count) {
+    pthread_mutex_lock(&grep->lock);
+    editorGrepPush(grep, found, count);
+    pthread_mutex_unlock(&grep->lock);
+  }
+  free(found);
+}
+
+void editorGrepAddLine(struct abuf *out, const char *path, long line, 
+  const char *text, size_t len) {
+  // a row of the results: where the line is, then the line itself
+  while (len > 0 && text[len-1] == '\r') {
+    len--;
+  }
+  if (len > CODIBLE_GREP_LINE) {
+    len = CODIBLE_GREP_LINE;
+  }
+  char where[64];
+  abAppend(out, path, strlen(path));
+  int wlen = snprintf(where, sizeof(where), ":%ld: ", line);
+  abAppend(out, where, wlen);
+  abAppend(out, text, len);
+  abAppend(out, "\n", 1);
+}
+
+int editorGrepFile(editorGrep *grep, editorSearch *search, 
+  const char *path, struct abuf *out, struct abuf *buffer) {
+  /* adding a row to out for each line of a file that matches, 
+     returns how many. a big file gets mapped instead of read, so 
+     it isn't copied. a small one costs less to read into buffer 
+     than to map & unmap
+  */
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    return 0;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size == 0) {
+    close(fd);
+    return 0;
+  }
+  size_t size = st.st_size;
+  char *text;
+  int mapped = (size >= CODIBLE_GREP_MAP);
+  if (mapped) {
+    text = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) {
+      return 0;
+    }
+    madvise(text, size, MADV_SEQUENTIAL);
+  }
+  else {
+    if ((size_t)buffer->len < size) {
+      free(buffer->b);
+      buffer->b = editorMallocArray(size, 1);
+      buffer->len = size;
+    }
+    text = buffer->b;
+    size_t done = 0;
+    ssize_t got;
+    while (done < size && (got = read(fd, &text[done], size - done)) > 0) {
+      done += got;
+    }
+    close(fd);
+    size = done;
+  }
+  // a NUL byte near the start means it isn't text
+  size_t head = (size < 8192) ? size : 8192;
+  if (memchr(text, '\0', head)) {
+    if (mapped) {
+      munmap(text, size);
+    }
+    return 0;
+  }
+  int found = 0;
+  long line = 1;
+  size_t start = 0; // of the line at line
+  if (search->regex == NULL && size < PTRDIFF_MAX) {
+    /* a string can't match across lines, so it gets searched for 
+       in the whole file at once & only the lines it turns up in
+       get counted to
+    */
+    ptrdiff_t at = 0;
+    while ((at = editorSearchForward(search, text, size, at)) != -1) {
+      char *newline;
+      while ((newline = memchr(&text[start], '\n', at - start))) {
+        line++;
+        start = newline - text + 1;
+      }
+      newline = memchr(&text[at], '\n', size - at);
+      size_t end = newline ? (size_t)(newline - text) : size;
+      editorGrepAddLine(out, path, line, &text[start], end - start);
+      found++;
+      if (newline == NULL || atomic_load(&grep->cancelled)) {
+        break;
+      }
+      line++;
+      start = end + 1;
+      at = start;
+    }
+  }
+  else {
+    // a regex reads a line at a time, its ^ & $ are about lines
+    while (start < size && !atomic_load(&grep->cancelled)) {
+      char *newline = memchr(&text[start], '\n', size - start);
+      size_t end = newline ? (size_t)(newline - text) : size;
+      if (end - start < PTRDIFF_MAX && 
+        editorSearchForward(search, &text[start], end - start, 0) != -1) {
+        editorGrepAddLine(out, path, line, &text[start], end - start);
+        found++;
+      }
+      line++;
+      start = end + 1;
+    }
+  }
+  if (mapped) {
+    munmap(text, size);
+  }
+  return found;
+}
+
+void *editorGrepWorker(void *arg) {
+  editorGrep *grep = arg;
+  // the DFAs of a regex grow while they read, each worker has its own
+  editorSearch search = {0};
+  editorSearchCompile(&search, grep->query, grep->flags);
+  // where the small files get read
+  struct abuf buffer = ABUF_INIT;
+  pthread_mutex_lock(&grep->lock);
+  while (1) {
+    // the others may still find more paths while they're busy
+    while (grep->pathcount == 0 && grep->busy > 0 && 
+      !atomic_load(&grep->cancelled)) {
+      pthread_cond_wait(&grep->work, &grep->lock);
+    }
+    if (grep->pathcount == 0 || atomic_load(&grep->cancelled)) {
+      break;
+    }
+    char *path = grep->paths[--grep->pathcount];
+    grep->busy++;
+    pthread_mutex_unlock(&grep->lock);
+
+    struct abuf out = ABUF_INIT;
+    int found = 0;
+    size_t len = strlen(path);
+    if (len == 0 || path[len-1] == '/') {
+      editorGrepDirectory(grep, path);
+    }
+    else {
+      found = editorGrepFile(grep, &search, path, &out, &buffer);
+    }
+    free(path);
+
+    pthread_mutex_lock(&grep->lock);
+    if (found) {
+      if (grep->outlen + out.len > grep->outcap) {
+        grep->outcap = (grep->outlen + out.len)*2;
+        grep->out = editorReallocArray(grep->out, grep->outcap, 1);
+      }
+      memcpy(&grep->out[grep->outlen], out.b, out.len);
+      grep->outlen += out.len;
+      grep->matches += found;
+      grep->files++;
+      if (grep->matches >= CODIBLE_GREP_RESULTS) {
+        atomic_store(&grep->cancelled, 1);
+      }
+    }
+    abFree(&out);
+    grep->busy--;
+    if (grep->busy == 0 && grep->pathcount == 0) {
+      // nothing is left, the others can stop waiting
+      pthread_cond_broadcast(&grep->work);
+    }
+  }
+  grep->running--;
+  pthread_cond_broadcast(&grep->work);
+  pthread_mutex_unlock(&grep->lock);
+  abFree(&buffer);
+  editorSearchFree(&search);
+  return NULL;
+}
+
+void editorGrepStop() {
+  // stopping the workers of a grep & forgetting it
+  editorGrep *grep = E.grep;
+  if (grep == NULL) {
+    return;
+  }
+  atomic_store(&grep->cancelled, 1);
+  pthread_mutex_lock(&grep->lock);
+  pthread_cond_broadcast(&grep->work);
+  pthread_mutex_unlock(&grep->lock);
+  for (int i=0; i<grep->threadcount; i++) {
+    pthread_join(grep->threads[i], NULL);
+  }
+  for (int k=0; k<grep->pathcount; k++) {
+    free(grep->paths[k]);
+  }
+  free(grep->paths);
+  free(grep->out);
+  free(grep->moving);
+  free(grep->query);
+  pthread_mutex_destroy(&grep->lock);
+  pthread_cond_destroy(&grep->work);
+  free(grep);
+  E.grep = NULL;
+}
+
+void editorGrepStatus() {
+  editorGrep *grep = E.grep;
+  pthread_mutex_lock(&grep->lock);
+  int matches = grep->matches, files = grep->files;
+  int running = grep->running > 0;
+  pthread_mutex_unlock(&grep->lock);
+  editorSetStatusMessage("Grep \"%.20s\": %d lines in %d files%s, "
+    "%.1f s%s", grep->query, matches, files, 
+    (matches >= CODIBLE_GREP_RESULTS) ? " (stopped there)" : "",
+    (editorMilliseconds() - grep->started)/1000.0, 
+    running ? ", searching..." : ". Enter opens a line");
+}
+
+int editorGrepIdle(long long deadline) {
+  /* moving the lines the workers found into rows while the editor
+     is idle, so they show up as they come in. what gets taken out
+     of out at once goes in over as many slices as it takes
+  */
+  editorGrep *grep = E.grep;
+  if (grep == NULL || grep->threadcount == 0) {
+    return 0;
+  }
+  int finished = 0;
+  if (grep->movingat == grep->movinglen) {
+    free(grep->moving);
+    pthread_mutex_lock(&grep->lock);
+    grep->moving = grep->out;
+    grep->movinglen = grep->outlen;
+    grep->movingat = 0;
+    grep->out = NULL;
+    grep->outlen = grep->outcap = 0;
+    finished = (grep->running == 0);
+    pthread_mutex_unlock(&grep->lock);
+  }
+  size_t moved = grep->movingat;
+  while (grep->movingat < grep->movinglen && 
+    editorMicroseconds() < deadline) {
+    char *line = &grep->moving[grep->movingat];
+    char *newline = memchr(line, '\n', grep->movinglen - grep->movingat);
+    editorInsertRow(E.numrows, line, newline - line);
+    grep->movingat = newline + 1 - grep->moving;
+  }
+  // the results aren't changes to anything that needs saving
+  E.dirty = 0;
+  if (finished && grep->movingat == grep->movinglen) {
+    for (int i=0; i<grep->threadcount; i++) {
+      pthread_join(grep->threads[i], NULL);
+    }
+    grep->threadcount = 0;
+  }
+  else {
+    /* the last of the lines are in once the workers are done & 
+       nothing's left to move
+    */
+    finished = 0;
+  }
+  if (grep->movingat == moved && !finished) {
+    return 0;
+  }
+  editorGrepStatus();
+  return 1;
+}
+
+void editorGrepStart(char *query) {
+  /* emptying the buffer for the results of a grep of query & 
+     starting its workers, which then own query
+  */
+  editorGrepStop();
+  editorCloseFile();
+  editorGrep *grep = calloc(1, sizeof(editorGrep));
+  if (grep == NULL) {
+    die("calloc");
+  }
+  grep->query = query;
+  grep->flags = E.searchflags;
+  grep->started = editorMilliseconds();
+  pthread_mutex_init(&grep->lock, NULL);
+  pthread_cond_init(&grep->work, NULL);
+  // the working directory, its files get shown without a "./"
+  char *root = editorMallocArray(1, 1);
+  root[0] = '\0';
+  editorGrepPush(grep, &root, 1);
+  E.grep = grep;
+  long count = 2*sysconf(_SC_NPROCESSORS_ONLN);
+  if (count < 2) {
+    count = 2;
+  }
+  if (count > CODIBLE_GREP_THREADS) {
+    count = CODIBLE_GREP_THREADS;
+  }
+  // resize signals are for the editor, not for the workers
+  sigset_t blocked, previous;
+  sigemptyset(&blocked);
+  sigaddset(&blocked, SIGWINCH);
+  pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+  pthread_mutex_lock(&grep->lock);
+  for (int i=0; i<count; i++) {
+    if (pthread_create(&grep->threads[grep->threadcount], NULL, 
+      editorGrepWorker, grep) == 0) {
+      grep->threadcount++;
+      grep->running++;
+    }
+  }
+  pthread_mutex_unlock(&grep->lock);
+  pthread_sigmask(SIG_SETMASK, &previous, NULL);
+  editorGrepStatus();
+}
+
+char *editorGrepResult(long *line) {
+  /* the path of the result the cursor is on & its line, NULL when 
+     it's on none. a row is "path:line: text"
+  */
+  if (E.cy >= E.numrows) {
+    return NULL;
+  }
+  erow *row = &E.row[E.cy];
+  char *colon = row->chars;
+  // the first ":<digits>: " is where the path ends
+  while ((colon = memchr(colon, ':', row->chars + row->size - colon))) {
+    char *end;
+    *line = strtol(colon + 1, &end, 10);
+    if (end > colon + 1 && isdigit((unsigned char)colon[1]) && 
+      end[0] == ':' && end[1] == ' ') {
+      break;
+    }
+    colon++;
+  }
+  if (colon == NULL) {
+    return NULL;
+  }
+  char *path = strndup(row->chars, colon - row->chars);
+  if (path == NULL) {
+    die("strndup");
+  }
+  return path;
+}
+
+/*** memory ***/
+
+void editorMemoryLine(struct abuf *ab, const char *name, ptrdiff_t blocks,
+  size_t bytes) {
+  // a line of the report: the blocks, their bytes & the bytes a row
+  char line[96];
+  int len = snprintf(line, sizeof(line), "%-20s %12td %14zu %10.1f\n", 
+    name, blocks, bytes, E.numrows ? (double)bytes/E.numrows : 0.0);
+  abAppend(ab, line, len);
+}
+
+char *editorMemoryReport(size_t *buflen) {
+  /* a report of where the memory of the buffer goes, one line for
+     each kind of array of its rows, the search structures & malloc's
+     own overhead. the rows were counted as they changed, only the 
+     search structures get looked at
+  */
+  static const char *kinds[MEMORY_KINDS] = {
+    "chars", "render", "highlight", "spans", "checkpoints", "wraps",
+    "erow array"
+  };
+  struct abuf ab = ABUF_INIT;
+  char line[96];
+  int len = snprintf(line, sizeof(line), "memory of %.40s, %td rows\n\n",
+    E.filename ? E.filename : "[No Name]", E.numrows);
+  abAppend(&ab, line, len);
+  len = snprintf(line, sizeof(line), "%-20s %12s %14s %10s\n", "", 
+    "blocks", "bytes", "bytes/row");
+  abAppend(&ab, line, len);
+  ptrdiff_t blocks = 0;
+  size_t bytes = 0;
+  for (int kind=0; kind<MEMORY_KINDS; kind++) {
+    editorMemoryLine(&ab, kinds[kind], E.memory.blocks[kind], 
+      E.memory.bytes[kind]);
+    blocks += E.memory.blocks[kind];
+    bytes += E.memory.bytes[kind];
+  }
+  editorMemoryLine(&ab, "rows in all", blocks, bytes);
+  abAppend(&ab, "\n", 1);
+
+  // the matches the find prompt keeps & the trigram index
+  editorFindState *find = &E.find;
+  size_t findbytes = find->results ? 
+    find->results->cap*sizeof(editorSearchMatch) : 0;
+  findbytes += find->chunkcap*sizeof(ptrdiff_t) + 
+    find->scratch.cap*sizeof(editorSearchMatch);
+  editorMemoryLine(&ab, "find matches", 0, findbytes);
+  size_t indexbytes = 0;
+  if (E.index) {
+    indexbytes = E.index->tablesize*sizeof(editorTrigram) + 
+      E.index->idcap*sizeof(ptrdiff_t) + E.index->longrows.cap;
+    for (int k=0; k<E.index->tablesize; k++) {
+      indexbytes += E.index->table[k].cap;
+    }
+  }
+  editorMemoryLine(&ab, "trigram index", 0, indexbytes);
+  abAppend(&ab, "\n", 1);
+
+  /* what malloc spends on top of what it hands out: a size word 
+     before every block, & the memory freed back to it that it 
+     keeps for later
+  */
+  editorMemoryLine(&ab, "malloc headers", blocks, blocks*sizeof(size_t));
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  struct mallinfo2 info = mallinfo2();
+  editorMemoryLine(&ab, "malloc free space", 0, info.fordblks);
+  editorMemoryLine(&ab, "malloc in all", 0, info.arena + info.hblkhd);
+#endif
+  *buflen = ab.len;
+  return ab.b;
+}
+
+size_t editorDropRenders() {
+  /* frees what the rows can make again from their chars: the 
+     renders, highlights & soft wrap points, for a buffer that isn't
+     shown. the spans & lexer states stay, so a row gets rendered &
+     highlighted on its own as it's drawn again. returns the bytes
+     freed
+  */
+  size_t before = E.memory.bytes[MEMORY_RENDER] + 
+    E.memory.bytes[MEMORY_HIGHLIGHT] + E.memory.bytes[MEMORY_WRAPS];
+  for (ptrdiff_t filerow=0; filerow<E.numrows; filerow++) {
+    erow *row = &E.row[filerow];
+    editorRowFree(MEMORY_RENDER, row->render);
+    row->render = NULL;
+    row->rsize = 0;
+    editorRowFree(MEMORY_HIGHLIGHT, row->highlight);
+    row->highlight = NULL;
+    editorRowFree(MEMORY_WRAPS, row->wraps);
+    row->wraps = NULL;
+    row->wrapcount = 0;
+    row->wrapwidth = 0;
+  }
+  return before - E.memory.bytes[MEMORY_RENDER] - 
+    E.memory.bytes[MEMORY_HIGHLIGHT] - E.memory.bytes[MEMORY_WRAPS];
+}
+
+/*** scripts ***/
+
+size_t editorScriptText(char *s) {
+  /* the text argument of a command, with \n, \t & \\ turned into 
+     what they stand for in place. returns its length
+  */
+  char *from = s, *to = s;
+  while (*from) {
+    if (from[0] == '\\' && (from[1] == 'n' || from[1] == 't' || 
+      from[1] == '\\')) {
+      *to++ = (from[1] == 'n') ? '\n' : (from[1] == 't') ? '\t' : '\\';
+      from += 2;
+    }
+    else {
+      *to++ = *from++;
+    }
+  }
+  *to = '\0';
+  return to - s;
+}
+
+int editorScriptCommand(char *command, char *arg, FILE *out) {
+  /* running one line of a script, returns -1 with the status 
+     message saying why if it can't be
+  */
+  char *end;
+  if (strcmp(command, "goto") == 0) {
+    // goto LINE [COLUMN], both of them counted from 1
+    long line = strtol(arg, &end, 10);
+    long column = strtol(end, &end, 10);
+    if (end == arg || *end != '\0') {
+      editorSetStatusMessage("goto needs a line number");
+      return -1;
+    }
+    editorJumpToRow(line - 1);
+    E.cx = (column > 1) ? column - 1 : 0;
+    editorClampCursor();
+  }
+  else if (strcmp(command, "mode") == 0) {
+    // the modes find, count & replace search with, none without any
+    E.searchflags = 0;
+    for (char *word = strtok(arg, " "); word; word = strtok(NULL, " ")) {
+      int flag = (strcmp(word, "case") == 0) ? SEARCH_IGNORE_CASE : 
+        (strcmp(word, "word") == 0) ? SEARCH_WHOLE_WORD : 
+        (strcmp(word, "regex") == 0) ? SEARCH_REGEX : 0;
+      if (flag == 0) {
+        editorSetStatusMessage("no mode %.40s, there's case, word & "
+          "regex", word);
+        return -1;
+      }
+      E.searchflags |= flag;
+    }
+  }
+  else if (strcmp(command, "find") == 0 || 
+    strcmp(command, "count") == 0 || strcmp(command, "replace") == 0) {
+    /* find TEXT moves to the next match after the cursor, count TEXT
+       counts them all, replace/TEXT/WITH/ replaces them all. any 
+       byte can stand in for the '/'
+    */
+    char *with = NULL;
+    if (command[0] == 'r') {
+      char delimiter = *arg++;
+      with = delimiter ? strchr(arg, delimiter) : NULL;
+      end = with ? strchr(with + 1, delimiter) : NULL;
+      if (end == NULL || end[1] != '\0') {
+        editorSetStatusMessage("replace needs /text/with/");
+        return -1;
+      }
+      *with++ = '\0';
+      *end = '\0';
+      editorScriptText(with);
+    }
+    editorScriptText(arg);
+    editorSearch search = {0};
+    if (editorSearchCompile(&search, arg, E.searchflags) == -1) {
+      editorSetStatusMessage("%.40s: %s", arg, search.error);
+      editorSearchFree(&search);
+      return -1;
+    }
+    if (command[0] == 'f') {
+      ptrdiff_t cx = E.cx, matchrow, matchcx;
+      if (E.cy < E.numrows) {
+        erow *row = &E.row[E.cy];
+        cx = editorSearchNext(&search, row->chars, row->size, cx);
+      }
+      if (editorSearchParallel(&search, E.cy, cx, 1, &matchrow, 
+        &matchcx) == 1) {
+        E.cy = matchrow;
+        E.cx = matchcx;
+        fprintf(out, "%td:%td\n", matchrow + 1, matchcx + 1);
+      }
+      else {
+        fprintf(out, "not found\n");
+      }
+    }
+    else if (command[0] == 'c') {
+      editorSearchResults results = {0};
+      ptrdiff_t count = 0;
+      if (editorSearchCollect(&search, &results) == 1) {
+        count = results.count;
+      }
+      else {
+        // too many to keep, they get counted a row at a time
+        for (ptrdiff_t r=0; r<E.numrows; r++) {
+          results.count = 0;
+          count += editorSearchCollectRow(&search, r, &results);
+        }
+      }
+      editorResultsFree(&results);
+      fprintf(out, "%td\n", count);
+    }
+    else {
+      ptrdiff_t rows;
+      ptrdiff_t replaced = editorReplaceAll(&search, with, &rows);
+      fprintf(out, "%td matches on %td lines\n", replaced, rows);
+    }
+    editorSearchFree(&search);
+  }
+  else if (strcmp(command, "insert") == 0) {
+    // insert TEXT, typed at the cursor
+    size_t len = editorScriptText(arg);
+    editorInsertText(arg, len);
+  }
+  else if (strcmp(command, "delete") == 0 || 
+    strcmp(command, "backspace") == 0) {
+    // the characters after or before the cursor, 1 unless it's said
+    long count = strtol(arg, &end, 10);
+    if (*end != '\0' || (end != arg && count < 0)) {
+      editorSetStatusMessage("%s needs a count", command);
+      return -1;
+    }
+    if (end == arg) {
+      count = 1;
+    }
+    for (long k=0; k<count; k++) {
+      if (command[0] == 'd') {
+        // stepping over the character, then deleting it
+        if (E.cy >= E.numrows || (E.cx == E.row[E.cy].size && 
+          E.cy == E.numrows - 1)) {
+          break;
+        }
+        erow *row = &E.row[E.cy];
+        if (E.cx < row->size) {
+          E.cx = editorRowNextChar(row, E.cx);
+        }
+        else {
+          E.cy++;
+          E.cx = 0;
+        }
+      }
+      editorDelChar();
+    }
+  }
+  else if (strcmp(command, "print") == 0 || 
+    strcmp(command, "highlight") == 0) {
+    /* print [FIRST [LAST]], the whole buffer without them. highlight
+       prints the state each line ends in & the highlight of every 
+       byte it renders to, a digit of enum editorHighlight
+    */
+    long first = strtol(arg, &end, 10);
+    char *second = end;
+    long last = strtol(second, &end, 10);
+    if (*end != '\0') {
+      editorSetStatusMessage("print needs line numbers");
+      return -1;
+    }
+    if (second == arg) {
+      first = 1;
+      last = E.numrows;
+    }
+    else if (end == second) {
+      last = first;
+    }
+    for (ptrdiff_t j=(first > 1) ? first - 1 : 0; j<last && j<E.numrows; 
+      j++) {
+      erow *row = &E.row[j];
+      if (command[0] == 'p') {
+        fwrite(row->chars, 1, row->size, out);
+      }
+      else {
+        fprintf(out, "%d ", row->hl_state);
+        if (row->size < CODIBLE_LONG_LINE && row->render == NULL) {
+          editorRowRender(row);
+        }
+        for (ptrdiff_t k=0; row->render && k<row->rsize; k++) {
+          fputc('0' + row->highlight[k], out);
+        }
+      }
+      fputc('\n', out);
+    }
+  }
+  else if (strcmp(command, "index") == 0) {
+    // building the trigram index, later searches of big files use it
+    if (E.index == NULL) {
+      editorIndexToggle();
+    }
+    editorIndexIdle(LLONG_MAX);
+  }
+  else if (strcmp(command, "memory") == 0) {
+    // where the memory of the buffer goes
+    size_t len;
+    char *report = editorMemoryReport(&len);
+    fwrite(report, 1, len, out);
+    free(report);
+  }
+  else if (strcmp(command, "save") == 0) {
+    // save [FILE], the file that was opened without one
+    if (*arg) {
+      free(E.filename);
+      E.filename = strdup(arg);
+      if (E.filename == NULL) {
+        die("strdup");
+      }
+    }
+    if (E.filename == NULL) {
+      editorSetStatusMessage("save needs a file name");
+      return -1;
+    }
+    if (editorSaveFile() == -1) {
+      return -1;
+    }
+    fprintf(out, "%s\n", E.statusmessage);
+  }
+  else {
+    editorSetStatusMessage("no command %.40s", command);
+    return -1;
+  }
+  return 0;
+}
+
+int editorRunScript(FILE *script, FILE *out) {
+  /* running the commands of a script on the buffer, one a line. 
+     lines starting with '#' are comments. nothing gets drawn, what
+     the commands find goes to out. returns -1 after telling stderr
+     about the first command that failed
+  */
+  char *line = NULL;
+  size_t linecap = 0;
+  ssize_t len;
+  long number = 0;
+  int status = 0;
+  while (status == 0 && (len = getline(&line, &linecap, script)) != -1) {
+    number++;
+    while (len>0 && (line[len-1]=='\n' || line[len-1]=='\r')) {
+      line[--len] = '\0';
+    }
+    if (len == 0 || line[0] == '#') {
+      continue;
+    }
+    // the command is the first word, the rest of the line its argument
+    char *arg = line + strcspn(line, " /");
+    char *command = strndup(line, arg - line);
+    if (command == NULL) {
+      die("strndup");
+    }
+    if (*arg == ' ') {
+      arg++;
+    }
+    status = editorScriptCommand(command, arg, out);
+    if (status == -1) {
+      fflush(out);
+      fprintf(stderr, "line %ld: %s: %s\n", number, command, 
+        E.statusmessage);
+    }
+    free(command);
+  }
+  free(line);
+  return status;
+}
+
+/*** profiler ***/
+
+long long editorProfileNow() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec*1000000000LL + ts.tv_nsec;
+}
+
+void editorProfileStart() {
+  // timing the frames of this thread from now on
+  editorProfileStop();
+  profiler.origin = profiler.mark = editorProfileNow();
+  profiler.on = 1;
+}
+
+void editorProfileStop() {
+  // the phases still open & the trace are dropped
+  free(profiler.events);
+  memset(&profiler, 0, sizeof(profiler));
+}
+
+void editorProfileEvent(long long start, long long duration, int phase) {
+  if (profiler.eventcount == profiler.eventcap) {
+    if (profiler.eventcap == CODIBLE_PROFILE_EVENTS) {
+      profiler.dropped++;
+      return;
+    }
+    profiler.eventcap = profiler.eventcap ? 2*profiler.eventcap : 4096;
+    profiler.events = editorReallocArray(profiler.events, 
+      profiler.eventcap, sizeof(editorTraceEvent));
+  }
+  editorTraceEvent *event = &profiler.events[profiler.eventcount++];
+  event->start = start - profiler.origin;
+  event->duration = duration;
+  event->phase = phase;
+}
+
+void editorProfileCharge(long long now) {
+  // the time since the last change goes to the phase open on top
+  if (profiler.depth > 0) {
+    profiler.frame[profiler.stack[profiler.depth - 1]] += 
+      now - profiler.mark;
+  }
+  profiler.mark = now;
+}
+
+void editorProfileBegin(int phase) {
+  /* a phase beginning inside itself, like the highlighting of a row
+     going on to the rows after it, is still the one phase
+  */
+  if (profiler.depth > 0 && profiler.stack[profiler.depth - 1] == phase) {
+    profiler.reentered[profiler.depth - 1]++;
+    return;
+  }
+  if (profiler.depth == CODIBLE_PROFILE_DEPTH) {
+    return;
+  }
+  long long now = editorProfileNow();
+  editorProfileCharge(now);
+  profiler.stack[profiler.depth] = phase;
+  profiler.starts[profiler.depth] = now;
+  profiler.reentered[profiler.depth] = 0;
+  profiler.depth++;
+}
+
+void editorProfileEnd(int phase) {
+  /* a phase that isn't the one open on top began before the profiler
+     was turned on, or too deep to be timed
+  */
+  if (profiler.depth == 0 || profiler.stack[profiler.depth - 1] != phase) {
+    return;
+  }
+  if (profiler.reentered[profiler.depth - 1] > 0) {
+    profiler.reentered[profiler.depth - 1]--;
+    return;
+  }
+  long long now = editorProfileNow();
+  editorProfileCharge(now);
+  profiler.depth--;
+  editorProfileEvent(profiler.starts[profiler.depth], 
+    now - profiler.starts[profiler.depth], phase);
+}
+
+void editorProfileFrame() {
+  /* a new frame starts, the one that ends is what the status bar
+     shows. the phases open go on into the new one
+  */
+  long long now = editorProfileNow();
+  editorProfileCharge(now);
+  memcpy(profiler.last, profiler.frame, sizeof(profiler.last));
+  memset(profiler.frame, 0, sizeof(profiler.frame));
+  editorProfileEvent(now, 0, PHASE_COUNT);
+}
+
+int editorProfileWrite(const char *filename) {
+  /* the trace in the Chrome trace event format, for chrome://tracing
+     or Perfetto. a complete event for each phase & an instant one 
+     for the start of each frame, in microseconds. returns -1 with 
+     errno set if it can't be written
+  */
+  FILE *fp = fopen(filename, "w");
+  if (fp == NULL) {
+    return -1;
+  }
+  fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (ptrdiff_t j=0; j<profiler.eventcount; j++) {
+    editorTraceEvent *event = &profiler.events[j];
+    if (event->phase == PHASE_COUNT) {
+      fprintf(fp, "{\"name\":\"frame\",\"ph\":\"i\",\"s\":\"p\","
+        "\"ts\":%.3f,\"pid\":1,\"tid\":1},\n", event->start/1000.0);
+    }
+    else {
+      fprintf(fp, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,"
+        "\"dur\":%.3f,\"pid\":1,\"tid\":1},\n", 
+        profile_phases[event->phase], event->start/1000.0, 
+        event->duration/1000.0);
+    }
+  }
+  // the metadata event has no comma after it
+  fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+    "\"tid\":1,\"args\":{\"name\":\"codible\"}}\n]}\n");
+  if (ferror(fp)) {
+    int saved = errno;
+    fclose(fp);
+    errno = saved;
+    return -1;
+  }
+  return fclose(fp) == 0 ? 0 : -1;
+}
+
+/*** idle tasks ***/
+
+/* the background work, highest priority first: the lines a grep 
+   found, then the rows a change left to highlight, then counting the
+   find prompt's matches, then building the trigram index
+*/
+const editorTask idle_tasks[] = {
+  {editorGrepIdle, CODIBLE_IDLE_SLICE/2},
+  {editorHighlightIdle, CODIBLE_IDLE_SLICE},
+  {editorFindIdle, CODIBLE_IDLE_SLICE},
+  {editorIndexIdle, CODIBLE_IDLE_SLICE},
+};
+
+void editorIdle() {
+  /* running the background work while no key is waiting. the first
+     task with work to do gets a slice of its budget, then the input
+     is looked at again, so a key waits for a slice at most. the
+     screen gets drawn every CODIBLE_RESIZE_INTERVAL ms meanwhile, & 
+     when all of it is done
+  */
+  struct pollfd fd = {E.input, POLLIN, 0};
+  long drawn = editorMilliseconds();
+  int worked = 0;
+  while (poll(&fd, 1, 0) == 0) {
+    int ran = 0;
+    for (size_t k=0; k<sizeof(idle_tasks)/sizeof(idle_tasks[0]) && !ran; 
+      k++) {
+      ran = idle_tasks[k].run(editorMicroseconds() + idle_tasks[k].budget);
+    }
+    if (!ran) {
+      if (worked) {
+        editorHookRefresh();
+      }
+      return;
+    }
+    worked = 1;
+    editorHookIdle();
+    if (editorMilliseconds() - drawn >= CODIBLE_RESIZE_INTERVAL) {
+      editorHookRefresh();
+      drawn = editorMilliseconds();
+    }
+  }
+}
+
+/*** embedding ***/
+
+/* the functions of codible.h take the editor they work on, each one
+   selects it for the call & puts back the one that was selected
+*/
+
+int codibleOpen(struct editorConfig *editor, char *filename) {
+  struct editorConfig *selected = codible_editor;
+  codibleSelect(editor);
+  int status = editorOpen(filename);
+  codibleSelect(selected);
+  return status;
+}
+
+int codibleSave(struct editorConfig *editor) {
+  if (editor->filename == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  struct editorConfig *selected = codible_editor;
+  codibleSelect(editor);
+  int status = editorSaveFile();
+  codibleSelect(selected);
+  return status;
+}
+
+void codibleMoveCursor(struct editorConfig *editor, ptrdiff_t row, 
+  ptrdiff_t column) {
+  struct editorConfig *selected = codible_editor;
+  codibleSelect(editor);
+  editorJumpToRow(row);
+  E.cx = (column < 0) ? 0 : column;
+  editorClampCursor();
+  codibleSelect(selected);
+}
+
+void codibleInsertChar(struct editorConfig *editor, int c) {
+  struct editorConfig *selected = codible_editor;
+  codibleSelect(editor);
+  editorInsertChar(c);
+  codibleSelect(selected);
+}
+
+void codibleInsertText(struct editorConfig *editor, const char *s, 
+  size_t len) {
+  struct editorConfig *selected = codible_editor;
+  codibleSelect(editor);
+  editorInsertText(s, len);
+  codibleSelect(selected);
+}
+
+void codibleDelChar(struct editorConfig *editor) {
+  struct editorConfig *selected = codible_editor;
+  codibleSelect(editor);
+  editorDelChar();
+  codibleSelect(selected);
+}
+
+char *codibleContents(struct editorConfig *editor, size_t *len) {
+  struct editorConfig *selected = codible_editor;
+  codibleSelect(editor);
+  char *buf = editorRowsToString(len);
+  codibleSelect(selected);
+  return buf;
+}
+
+ptrdiff_t codibleReplaceAll(struct editorConfig *editor, 
+  const char *query, int flags, const char *with, ptrdiff_t *rows) {
+  struct editorConfig *selected = codible_editor;
+  codibleSelect(editor);
+  ptrdiff_t replaced = -1;
+  editorSearch search = {0};
+  *rows = 0;
+  if (editorSearchCompile(&search, query, flags) != -1) {
+    replaced = editorReplaceAll(&search, with, rows);
+  }
+  editorSearchFree(&search);
+  codibleSelect(selected);
+  return replaced;
+}
+
+int codibleRunScript(struct editorConfig *editor, FILE *script, 
+  FILE *out) {
+  struct editorConfig *selected = codible_editor;
+  codibleSelect(editor);
+  int status = editorRunScript(script, out);
+  codibleSelect(selected);
+  return status;
+}
+
+void codibleIdle(struct editorConfig *editor) {
+  struct editorConfig *selected = codible_editor;
+  codibleSelect(editor);
+  editorIdle();
+  codibleSelect(selected);
+}
@@ -0,0 +1,829 @@
+/*** codible core internals ***/
+
+/* the editor without a terminal: the rows of a buffer, editing 
+   them, highlighting, searching & grepping. all of it works on the
+   editor selected with codibleSelect(), which E stands for. a 
+   frontend shows it & feeds it keys, codible.c does that on a 
+   terminal & runs scripts in batch mode. only codible_core.c & 
+   codible.c include this, a program embedding the editor gets 
+   codible.h
+*/
+
+#ifndef CODIBLE_INTERNAL_H
+#define CODIBLE_INTERNAL_H
+
+/*** includes ***/
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <ctype.h> // iscntrl() resides in it
+#include <stdio.h> 
+/* printf(), perror(), sscanf(), snprintf(), FILE,
+   fopen(), getline(), vsnprintf() reside in it
+*/
+#include <stdlib.h> 
+// atexit(), exit(), realloc(), free(), malloc() reside in it 
+#include <unistd.h> 
+/* read(), STDIN_FILENO, write(), STDOUT_FILENO
+   ftruncate(), close() reside in it
+*/
+#include <errno.h> // errno, EAGAIN reside in it
+#include <string.h> 
+/* memcpy(), strlen(), strdup(), memmove(), strerror(), 
+   strstr(), memset(), strchr(), strrchr(), strcmp(), 
+   strncmp() reside in it
+*/
+#include <sys/types.h> // ssize_t resides in it
+#include <stddef.h> // ptrdiff_t resides in it
+#include <stdint.h> // SIZE_MAX, PTRDIFF_MAX reside in it
+#include <time.h> 
+// time_t, time(), clock_gettime(), CLOCK_MONOTONIC reside in it
+#include <stdarg.h> // va_list, va_start(), va_end() reside in it
+#include <fcntl.h> // open(), O_RDWR, O_CREAT reside in it 
+#include <signal.h> 
+// sigaction(), SIGWINCH, sig_atomic_t reside in it
+#include <pthread.h> 
+/* pthread_create(), pthread_mutex_lock(), pthread_cond_wait(),
+   pthread_sigmask() reside in it
+*/
+#include <poll.h> // poll(), struct pollfd, POLLIN reside in it
+#include <stdatomic.h> // atomic_int, atomic_load() reside in it
+#include <limits.h> // INT_MAX resides in it
+#include <dirent.h> // opendir(), readdir(), DT_DIR reside in it
+#include <sys/mman.h> // mmap(), munmap(), madvise() reside in it
+#include <sys/stat.h> // fstat(), lstat(), S_ISDIR() reside in it
+#include <malloc.h> 
+// malloc_usable_size(), mallinfo2() reside in it
+#ifdef __SSE2__
+#include <emmintrin.h> 
+// __m128i, _mm_loadu_si128(), _mm_movemask_epi8() reside in it
+#endif
+
+#include "codible.h"
+
+/*** defines ***/
+
+#define CODIBLE_VERSION "0.0.1"
+#define CODIBLE_TAB_STOP 8
+/* rows at least this long only render & highlight a window 
+   around the visible columns
+*/
+#define CODIBLE_LONG_LINE 65536
+// columns rendered on each side of the visible part of a long row
+#define CODIBLE_LONG_LINE_MARGIN 4096
+// distance in chars between two saved lexer states of a long row
+#define CODIBLE_HL_CHECKPOINT 4096
+// at most this many threads highlight a file that just got opened
+#define CODIBLE_HL_THREADS 8
+/* files with fewer bytes than this get highlighted by the editor
+   itself, starting the threads would take longer
+*/
+#define CODIBLE_HL_PARALLEL (1<<18)
+/* a resize gets drawn once the window size stayed the same for 
+   CODIBLE_RESIZE_QUIET ms, or every CODIBLE_RESIZE_INTERVAL ms while
+   the window keeps being dragged
+*/
+#define CODIBLE_RESIZE_QUIET 40
+#define CODIBLE_RESIZE_INTERVAL 200
+// at most this many threads search the rows of a file
+#define CODIBLE_SEARCH_THREADS 8
+/* rows a search worker takes at once, files with fewer rows are
+   searched by the editor itself
+*/
+#define CODIBLE_SEARCH_CHUNK 4096
+/* matches of a query the find prompt keeps, a query with more of 
+   them gets searched for one match at a time. gathering them stops
+   there, so giving up on a common string stays quick
+*/
+#define CODIBLE_SEARCH_RESULTS (1<<14)
+/* microseconds a background task works in one go while the editor
+   is idle, a key that comes in never waits much longer than that
+*/
+#define CODIBLE_IDLE_SLICE 1000
+/* ids that rows left behind in the trigram index, on top of twice
+   the rows, before it gets built again from scratch
+*/
+#define CODIBLE_INDEX_SLACK (1<<16)
+/* a list of a query trigram this many times longer than the rows
+   left over costs more to read than checking those rows does
+*/
+#define CODIBLE_INDEX_INTERSECT 16
+/* a trigram in more than a quarter of the rows, & in this many at 
+   least, loses its list: it'd take a byte a row & narrow nothing
+*/
+#define CODIBLE_INDEX_DENSE 4096
+/* the most threads a grep of a directory tree runs. it runs twice
+   as many as there are processors, so some read while others search
+*/
+#define CODIBLE_GREP_THREADS 16
+/* files of this many bytes & more get mapped by a grep, smaller 
+   ones are read
+*/
+#define CODIBLE_GREP_MAP (1<<18)
+// a grep stops once it has this many matching lines
+#define CODIBLE_GREP_RESULTS 100000
+// the bytes of a matching line a grep shows
+#define CODIBLE_GREP_LINE 256
+
+enum editorHighlight {
+  HL_NORMAL = 0,
+  HL_COMMENT,
+  HL_MLCOMMENT,
+  HL_KEYWORD1,
+  HL_KEYWORD2,
+  HL_STRING,
+  HL_NUMBER,
+  HL_MATCH,
+  HL_MATCH_CURRENT
+};
+
+/* states a syntax's lexer can have, a transition keeps the state in
+   its low 12 bits & the token it ends in the high 4
+*/
+#define CODIBLE_LEX_STATES 4096
+#define LEX_STATE(t) ((t) & 0xfff)
+// 1 + the highlight of the token a transition ends, 0 if it ends none
+#define LEX_TOKEN(t) ((t) >> 12)
+// longest delimiter of a comment, string or block in a syntax file
+#define CODIBLE_LEX_DELIMITER 64
+// multi line comments & strings a syntax file can have
+#define CODIBLE_LEX_BLOCKS 8
+
+/* the modes of a lexer while a syntax gets compiled, its states are
+   the modes it can reach with their nodes
+*/
+enum editorLexMode {
+  LEX_BASE = 0, // plain text after a separator
+  LEX_WORD, // plain text after anything else
+  LEX_KEYWORD, // a word still in the keyword trie, node is where
+  LEX_NUMBER,
+  LEX_STRING, // node is the quote
+  LEX_ESCAPE, // right after a backslash in a string
+  LEX_STRING_END, // right after the closing quote
+  LEX_COMMENT, // up to the end of the row
+  /* a multi line comment or string, node is the block times 
+     CODIBLE_LEX_DELIMITER plus the bytes of its end there are
+  */
+  LEX_BLOCK, 
+  LEX_BLOCK_END, // right after the end of block node
+  LEX_OPENER, // the start of a delimiter, node in the opener trie
+  LEX_MODES
+};
+
+// largest NFA a regex may compile to, counted in nodes
+#define CODIBLE_REGEX_NODES 20000
+// longest literal prefix pulled out of a regex
+#define CODIBLE_REGEX_PREFIX 64
+/* states a lazily built DFA keeps, when they run out it forgets 
+   all of them & starts over
+*/
+#define CODIBLE_DFA_STATES 1024
+
+// flags of a DFA state
+#define DFA_ACCEPT (1<<0) // a match ends here
+#define DFA_ACCEPT_END (1<<1) // a match ends here if the text does
+#define DFA_DEAD (1<<2) // no match can go on from here
+
+/* trace events the profiler keeps, 24 bytes each. the ones after 
+   them are only counted
+*/
+#define CODIBLE_PROFILE_EVENTS (1<<20)
+// phases the profiler can have open one inside another
+#define CODIBLE_PROFILE_DEPTH 16
+
+// what the memory of the rows of a buffer is counted as
+enum editorMemoryKind {
+  MEMORY_CHARS = 0,
+  MEMORY_RENDER,
+  MEMORY_HIGHLIGHT,
+  MEMORY_SPANS,
+  MEMORY_CHECKPOINTS,
+  MEMORY_WRAPS,
+  MEMORY_ROWS, // the erow array itself
+  MEMORY_KINDS
+};
+
+// the phases of a frame the profiler times
+enum editorPhase {
+  PHASE_READ = 0, // waiting for a key & reading it
+  PHASE_UPDATE, // what the key does to the buffer
+  PHASE_HIGHLIGHT,
+  PHASE_SCROLL,
+  PHASE_DRAW,
+  PHASE_WRITE, // the frame going out to the terminal
+  PHASE_COUNT
+};
+
+/*** data ***/
+
+/* a language read from a syntax file & compiled to the tables of a
+   lexer DFA, so highlighting looks up one transition a byte. 
+   next[state<<8 | byte] is a transition, it can end the token open
+   before the byte, all of whose bytes get its highlight. a row ends
+   with the token open in eolhighlight & the next row starts in 
+   eolnext, which only multi line comments & strings carry over
+*/
+struct editorSyntax {
+  char *filetype;
+  char **filematch; // extensions & parts of file names, NULL ended
+  int states;
+  uint16_t *next;
+  unsigned char *eolhighlight;
+  uint16_t *eolnext;
+};
+
+/* highlighting every row of a file at once. the rows are cut into
+   chunks of about the same bytes, which the workers highlight as if
+   each started in the start state of the lexer
+*/
+typedef struct editorHighlightJob {
+  struct editorConfig *editor;
+  ptrdiff_t *chunks; // chunk k is rows chunks[k] .. chunks[k+1]-1
+  ptrdiff_t chunkcount;
+  atomic_ptrdiff_t nextchunk;
+} editorHighlightJob;
+
+/* words or delimiters a syntax file lists, by byte. node 0 is the
+   root, a child of 0 is no child
+*/
+typedef struct editorTrie {
+  int (*child)[256];
+  int *accept; // what a word ending at the node is, -1 for nothing
+  int *parent;
+  unsigned char *byte; // the byte leading to the node
+  int nodes, cap;
+} editorTrie;
+
+// a multi line comment or string of a syntax file
+typedef struct editorLexBlock {
+  char *end;
+  int highlight;
+} editorLexBlock;
+
+/* a syntax file as it's read, before it gets compiled. a delimiter
+   accepts LEX_COMMENT, LEX_STRING or LEX_BLOCK in its high bits & 
+   the quote or block in its low 8
+*/
+typedef struct editorSyntaxSource {
+  editorTrie keywords; // accepting HL_KEYWORD1 or HL_KEYWORD2
+  editorTrie openers;
+  editorLexBlock blocks[CODIBLE_LEX_BLOCKS];
+  int blockcount;
+  int numbers;
+  unsigned char separators[256];
+} editorSyntaxSource;
+
+typedef struct editorLexConfig {
+  int mode;
+  int node;
+} editorLexConfig;
+
+/* a character of a row that doesn't take exactly one byte in chars,
+   one byte in render & one column on the screen: a tab or a 
+   multibyte UTF-8 sequence. rb & rx say where the character after
+   it starts in render & on the screen. all the characters between 
+   two spans map one to one, so the spans are enough to convert 
+   between cx, render bytes & columns without scanning
+*/
+typedef struct erowSpan {
+  ptrdiff_t cx; // where the character starts in chars
+  ptrdiff_t rb;
+  ptrdiff_t rx;
+  unsigned char len; // bytes it takes in chars
+  unsigned char width; // columns of a multibyte character
+} erowSpan;
+
+// an inclusive range of Unicode code points
+typedef struct editorRange {
+  int first;
+  int last;
+} editorRange;
+
+/* lexer state saved before chars[cx] of a long row, highlighting
+   can start from the nearest one instead of the row start
+*/
+typedef struct erowCheckpoint {
+  ptrdiff_t cx;
+  int state;
+} erowCheckpoint;
+
+// editor row
+typedef struct erow {
+  // index of the row in the file at the time it is inserted
+  ptrdiff_t index;
+  // the size of rendering characters
+  ptrdiff_t size;
+  ptrdiff_t rsize;
+  // store a line of text as a pointer
+  char *chars;
+  // for rendering the non-printable characters;
+  char *render;
+  // highlighted array
+  unsigned char *highlight;
+  // the lexer state the row ends in, the next row starts in it
+  int hl_state;
+  /* the row before changed the state it ends in since this one got
+     highlighted, it waits for it in the idle time or until drawn
+  */
+  int hl_stale;
+  // span index sorted by cx
+  erowSpan *spans;
+  ptrdiff_t spancount;
+  /* render holds chars[cwin .. cwinend). it's the whole row unless
+     the row is long and only a window of it is rendered
+  */
+  ptrdiff_t cwin;
+  ptrdiff_t cwinend;
+  // lexer checkpoints, only kept for long rows
+  erowCheckpoint *checkpoints;
+  ptrdiff_t checkpointcount;
+  /* screen columns where the visual lines after the first one
+     start in soft wrap mode, computed for a screen wrapwidth
+     columns wide. wrapwidth is 0 while they need computing
+  */
+  ptrdiff_t *wraps;
+  ptrdiff_t wrapcount;
+  int wrapwidth;
+  int id; // in the trigram index, -1 while it isn't indexed
+
+} erow;
+
+/* a query prepared for searching: Horspool shifts for every byte
+   & the bytes the SIMD filter compares, both of them folded to
+   lower case when the case gets ignored
+*/
+typedef struct editorSearch {
+  char *pattern; // the query as it was typed
+  const char *error; // why the pattern isn't a valid regex
+  struct editorRegex *regex; // NULL when a plain string gets searched
+  char *query;
+  ptrdiff_t len;
+  int flags;
+  ptrdiff_t shift[256];
+#ifdef __SSE2__
+  // the filtered bytes of the query in both cases, 16 times over
+  __m128i lower[3];
+  __m128i upper[3];
+  ptrdiff_t offsets[3];
+#endif
+} editorSearch;
+
+/* the parts a regex is made of, as the parser finds them. the 
+   compiler turns them into the nodes of an NFA, which is read
+   forward to find where matches end & backward to find where they 
+   start
+*/
+enum editorRegexAstOp {
+  AST_SET, // one byte out of a set
+  AST_CAT,
+  AST_ALT,
+  AST_REPEAT, // left, between min & max times, max -1 for no limit
+  AST_EMPTY,
+  AST_BEGIN, // ^
+  AST_END // $
+};
+
+typedef struct editorRegexAst {
+  int op;
+  int left, right;
+  int set;
+  int min, max;
+} editorRegexAst;
+
+/* RX_CHAR reads one byte of a set, RX_SPLIT goes on to both of
+   its outs without reading. RX_BEGIN & RX_END only let through where the
+   row begins or ends in the direction it's read in
+*/
+enum editorRegexOp {
+  RX_CHAR,
+  RX_SPLIT,
+  RX_BEGIN,
+  RX_END,
+  RX_MATCH
+};
+
+typedef struct editorRegexNode {
+  int op;
+  int out, out1;
+  int set;
+} editorRegexNode;
+
+/* a DFA built from the NFA while it reads, one state per set of 
+   NFA nodes the text actually leads to. an unanchored DFA adds the
+   start of the NFA at every position, so a match may start anywhere
+*/
+typedef struct editorDfa {
+  int entry;
+  int unanchored;
+  int count;
+  int flushes; // times the states got forgotten
+  int *first; // where the nodes of each state start in lists
+  int *size;
+  int *lists;
+  int listlen, listcap;
+  /* a row of width ints for each state: its DFA_* flags, then its
+     transition on each class of bytes, -1 until that's first taken.
+     states are known by where their row starts
+  */
+  int width;
+  int *next;
+  int *hash; // open addressing table of the states by their nodes
+  int starts[2]; // start state away from & at the row boundary
+} editorDfa;
+
+// the DFAs of a regex
+enum editorDfaKind {
+  DFA_SEARCH, // forward, unanchored: where the first match ends
+  DFA_LONGEST, // forward, anchored: where the longest match ends
+  DFA_STARTS // backward, unanchored: where the first match starts
+};
+
+typedef struct editorRegex {
+  editorRegexNode *nodes;
+  int nodecount, nodecap;
+  unsigned char (*sets)[32];
+  int setcount, setcap;
+  /* bytes no set tells apart share a class, the DFAs only keep 
+     transitions for the classes
+  */
+  unsigned char classes[256];
+  int classcount;
+  editorDfa dfas[3];
+  // scratch space for collecting the NFA nodes of a state
+  int *marks;
+  int mark;
+  int *stack;
+  int *list;
+  int *endlist;
+  /* every match starts with the prefix, the literal search skips
+     to it whenever no match is under way
+  */
+  int hasprefix;
+  editorSearch prefix;
+  /* a string every match has somewhere, when it's longer than the
+     prefix. rows without it are skipped whole
+  */
+  int hasrequired;
+  editorSearch required;
+} editorRegex;
+
+typedef struct editorRegexParser {
+  const char *p; // next byte of the pattern
+  int flags;
+  editorRegexAst *ast;
+  int astcount, astcap;
+  editorRegex *regex; // where the byte sets go
+  const char *error;
+} editorRegexParser;
+
+typedef struct editorSearchMatch {
+  ptrdiff_t row;
+  ptrdiff_t cx;
+} editorSearchMatch;
+
+// the matches of a query, in the order of the file
+typedef struct editorSearchResults {
+  editorSearchMatch *matches;
+  ptrdiff_t count, cap;
+} editorSearchResults;
+
+/* the search workers & the one job they share. a search of the
+   whole file is cut into chunks of rows ordered by their distance
+   from the start, chunk k holds the rows k*CODIBLE_SEARCH_CHUNK ..
+   steps away in the search direction
+*/
+typedef struct editorSearchPool {
+  pthread_t threads[CODIBLE_SEARCH_THREADS];
+  int threadcount; // 0 until the first big search starts them
+  pthread_mutex_t lock;
+  pthread_cond_t work; // there is a chunk to take
+  pthread_cond_t idle; // no worker is in the middle of a chunk
+  // written to by the worker that finds the job done
+  int wakeup[2];
+  /* held for a whole job, editors in different threads take turns
+     with the workers
+  */
+  pthread_mutex_t jobs;
+  // the job, set up by the editor while no worker is busy
+  struct editorConfig *editor; // the rows it searches
+  editorSearch *search;
+  ptrdiff_t filerow, cx;
+  int direction;
+  ptrdiff_t numrows;
+  ptrdiff_t chunkcount;
+  ptrdiff_t nextchunk;
+  int busy;
+  int finished;
+  /* gathering every match instead of the nearest one, chunk k is 
+     then rows k*CODIBLE_SEARCH_CHUNK .. & its matches go to 
+     chunkresults[k]
+  */
+  int collect;
+  editorSearchResults *chunkresults;
+  atomic_ptrdiff_t found;
+  // nearest chunk with a match so far, chunkcount if there is none
+  atomic_ptrdiff_t best;
+  atomic_int cancelled;
+  ptrdiff_t matchrow, matchcx;
+} editorSearchPool;
+
+/* the rows a trigram turns up in, by row id. ids only ever get 
+   appended in increasing order, each one as the varint of its 
+   distance from the one before
+*/
+typedef struct editorTrigram {
+  unsigned int key; // the three bytes plus 1, 0 for a free slot
+  int last; // the id appended last
+  int count; // -1 once it's in too many rows to be worth a list
+  ptrdiff_t len, cap;
+  unsigned char *ids;
+} editorTrigram;
+
+/* trigram index of the rows of a buffer, folded to lower case. a 
+   row gets a new id every time it's indexed, so the lists stay 
+   sorted without being rewritten & the ids it had before just stop
+   leading anywhere. long rows aren't split into trigrams, every 
+   query checks them
+*/
+typedef struct editorIndex {
+  editorTrigram *table; // open addressing by key
+  int tablesize; // a power of 2
+  int trigrams;
+  editorTrigram longrows;
+  ptrdiff_t *rows; // the row each id is on now, -1 once it's gone
+  int ids, idcap;
+  ptrdiff_t built; // rows 0 .. built-1 are indexed
+  double buildtime; // seconds spent building
+  int announce; // telling how big it is once it's built
+} editorIndex;
+
+/* what the find prompt shows while it's open: every match on the 
+   screen, & where the current match is among all of them. without
+   a complete list of the matches, they get counted a slice of rows
+   at a time while no key is waiting, chunkcounts[k] has those of 
+   rows k*CODIBLE_SEARCH_CHUNK ..
+*/
+typedef struct editorFindState {
+  editorSearch *search; // NULL while the prompt is closed
+  ptrdiff_t matchrow, matchcx; // the current match, matchrow -1 if none
+  ptrdiff_t position; // its number among the matches, 0 until it's known
+  editorSearchResults *results; // in order of the file
+  int complete; // whether results has every match
+  ptrdiff_t *chunkcounts;
+  ptrdiff_t chunkcap;
+  ptrdiff_t counted; // rows 0 .. counted-1 are counted
+  ptrdiff_t total; // the matches in those rows
+  editorSearchResults scratch; // the matches of the row being counted
+} editorFindState;
+
+/* a grep of the files under the working directory, filling the 
+   buffer with a row for each matching line. the workers share a
+   stack of the paths still to look at, directories add what they
+   hold to it. the lines they find wait in out until the editor is
+   idle & moves them into rows
+*/
+typedef struct editorGrep {
+  char *query;
+  int flags; // SEARCH_* modes
+  pthread_t threads[CODIBLE_GREP_THREADS];
+  int threadcount;
+  pthread_mutex_t lock;
+  pthread_cond_t work; // there is a path to take, or nothing is left
+  char **paths;
+  int pathcount, pathcap;
+  int busy; // workers in the middle of a path
+  int running; // workers that haven't finished
+  atomic_int cancelled;
+  char *out; // rows not in the buffer yet, one per line
+  size_t outlen, outcap;
+  // taken out of out by the editor, going into rows a slice at a time
+  char *moving;
+  size_t movinglen, movingat;
+  int matches, files;
+  long started; // editorMilliseconds() when it started
+} editorGrep;
+
+/* background work the editor does while no key is waiting. run 
+   does a slice of it, stopping once editorMicroseconds() reaches the
+   deadline, & returns whether there was any to do
+*/
+typedef struct editorTask {
+  int (*run)(long long deadline);
+  int budget; // microseconds a slice may take
+} editorTask;
+
+typedef struct editorTraceEvent {
+  long long start, duration; // in nanoseconds
+  int phase; // PHASE_COUNT for the start of a frame
+} editorTraceEvent;
+
+/* the frame profiler. while it's on, the phases of every frame get
+   timed, a phase only for the time no phase inside of it is open, 
+   so the times of a frame add up to its length. each phase that 
+   ends is kept as an event for a trace. the thread that turns it
+   on is the only one it times
+*/
+typedef struct editorProfiler {
+  int on;
+  long long origin; // when it was turned on
+  long long mark; // the time of the last phase change
+  int stack[CODIBLE_PROFILE_DEPTH]; // the open phases
+  long long starts[CODIBLE_PROFILE_DEPTH];
+  // times the phase at each depth was begun again inside itself
+  int reentered[CODIBLE_PROFILE_DEPTH]; 
+  int depth;
+  long long frame[PHASE_COUNT]; // the frame going on
+  long long last[PHASE_COUNT]; // the one before it
+  editorTraceEvent *events;
+  ptrdiff_t eventcount, eventcap;
+  ptrdiff_t dropped; // events past CODIBLE_PROFILE_EVENTS
+} editorProfiler;
+
+/* the memory the rows of a buffer hold, counted by every site that
+   allocates or frees one of their arrays, so it's known without 
+   looking at the rows. bytes are what malloc_usable_size() says, 
+   the bytes asked for plus what malloc rounded them up by
+*/
+typedef struct editorMemory {
+  ptrdiff_t blocks[MEMORY_KINDS];
+  size_t bytes[MEMORY_KINDS];
+} editorMemory;
+
+struct editorConfig {
+  ptrdiff_t cx, cy;
+  ptrdiff_t rx;
+  ptrdiff_t rowoff;
+  ptrdiff_t coloff;
+  int wrap; // soft wrap display mode
+  ptrdiff_t wrapoff; // visual line of row rowoff shown at the top
+  int searchflags; // SEARCH_* modes, kept from one search to the next
+  // cursor position on the screen, set by editorScroll()
+  int cursory, cursorx;
+  int screenrows;
+  int screencolumns;
+  ptrdiff_t numrows; // number of rows to be displayed
+  erow *row;  // making erow arrays for taking multiple lines
+  int dirty;  // identify if the buffer is changed
+  char *filename;
+  char statusmessage[80];
+  time_t statusmessage_time;
+  struct editorSyntax *syntax;
+  // no row before hlstale is stale, hlstalecount of them are
+  ptrdiff_t hlstale, hlstalecount;
+  editorIndex *index; // NULL while the trigram index is off
+  editorFindState find;
+  editorGrep *grep; // NULL unless the buffer shows a grep's results
+  editorMemory memory;
+  /* the frontend showing the editor. a key waiting on input cuts 
+     long work short, -1 if keys don't come from a descriptor. 
+     refresh redraws the screen & idle keeps up with it while the
+     work goes on, either of them NULL when there's nothing to show
+  */
+  int input;
+  void (*refresh)(void);
+  void (*idle)(void);
+};
+
+/*** append buffer ***/
+
+struct abuf {
+  char *b;
+  size_t len;
+};
+
+#define ABUF_INIT {NULL, 0} 
+/* initially pointing to the empty buffer
+   worked as a constructor
+*/
+
+/*** globals ***/
+
+/* the editor E stands for. each thread selects its own, the search
+   workers select the one whose job they are on
+*/
+extern _Thread_local struct editorConfig *codible_editor;
+#define E (*codible_editor)
+
+extern editorSearchPool search_pool;
+
+extern _Thread_local editorProfiler profiler;
+extern const char *profile_phases[PHASE_COUNT];
+/* timing a phase, nothing more than a test of profiler.on while the
+   profiler is off
+*/
+#define PROFILE_BEGIN(phase) \
+  do { if (profiler.on) editorProfileBegin(phase); } while (0)
+#define PROFILE_END(phase) \
+  do { if (profiler.on) editorProfileEnd(phase); } while (0)
+#define PROFILE_FRAME() \
+  do { if (profiler.on) editorProfileFrame(); } while (0)
+
+/* called before a fatal error exits, a frontend puts its terminal 
+   back the way it was there
+*/
+extern void (*die_cleanup)(void);
+
+/*** core ***/
+
+void die(const char *s);
+void *editorReallocArray(void *p, ptrdiff_t count, size_t size);
+void *editorMallocArray(ptrdiff_t count, size_t size);
+long editorMilliseconds();
+long long editorMicroseconds();
+void codibleSelect(struct editorConfig *editor);
+void editorSetStatusMessage(const char *fmt, ...);
+
+int editorCharWidth(int cp);
+int editorUtf8Decode(const char *s, ptrdiff_t len, int *cp);
+
+ptrdiff_t editorRowCxToRx(erow *row, ptrdiff_t cx);
+ptrdiff_t editorRowCxToRb(erow *row, ptrdiff_t cx);
+ptrdiff_t editorRowRxToCx(erow *row, ptrdiff_t rx);
+ptrdiff_t editorRowNextChar(erow *row, ptrdiff_t cx);
+ptrdiff_t editorRowPrevChar(erow *row, ptrdiff_t cx);
+ptrdiff_t editorRowCharStart(erow *row, ptrdiff_t cx);
+void editorUpdateSyntax(erow *row);
+int editorHighlightStale(ptrdiff_t upto, long long deadline);
+void editorRowRenderWindow(erow *row, ptrdiff_t col, int width);
+void editorRowRender(erow *row);
+void editorInsertRow(ptrdiff_t at, char *s, size_t len);
+void editorDelRow(ptrdiff_t at);
+int editorWrapWidth();
+ptrdiff_t editorRowVisualLines(erow *row);
+ptrdiff_t editorRowWrapStart(erow *row, ptrdiff_t line);
+ptrdiff_t editorRowVisualLine(erow *row, ptrdiff_t rx);
+int editorWrapStep(ptrdiff_t *filerow, ptrdiff_t *line, int direction);
+
+void editorInsertChar(int c);
+void editorInsertNewLine();
+void editorInsertText(const char *s, size_t len);
+void editorDelChar();
+void editorClampCursor();
+void editorJumpToRow(ptrdiff_t filerow);
+
+char *editorMemoryReport(size_t *buflen);
+size_t editorDropRenders();
+
+char *editorRowsToString(size_t *buflen);
+void editorCloseFile();
+int editorOpen(char *filename);
+int editorSaveFile();
+void editorSyntaxLoad();
+void editorSelectSyntaxHighlight();
+
+int editorSearchCompile(editorSearch *search, const char *pattern, 
+  int flags);
+void editorSearchFree(editorSearch *search);
+ptrdiff_t editorSearchForward(editorSearch *search, const char *text, 
+  ptrdiff_t len, ptrdiff_t from);
+ptrdiff_t editorSearchNext(editorSearch *search, const char *text, 
+  ptrdiff_t len, ptrdiff_t at);
+ptrdiff_t editorSearchMatchEnd(editorSearch *search, const char *text, 
+  ptrdiff_t len, ptrdiff_t at);
+int editorSearchRows(editorSearch *search, ptrdiff_t filerow, 
+  ptrdiff_t cx, int direction, ptrdiff_t *matchrow, ptrdiff_t *matchcx);
+ptrdiff_t editorSearchCollectRow(editorSearch *search, ptrdiff_t filerow, 
+  editorSearchResults *results);
+void editorResultsFree(editorSearchResults *results);
+void editorResultsNarrow(editorSearch *search, 
+  editorSearchResults *results);
+int editorResultsNearest(editorSearchResults *results, ptrdiff_t filerow,
+  ptrdiff_t cx, int direction, ptrdiff_t *matchrow, ptrdiff_t *matchcx);
+int editorSearchParallel(editorSearch *search, ptrdiff_t filerow, 
+  ptrdiff_t cx, int direction, ptrdiff_t *matchrow, ptrdiff_t *matchcx);
+int editorSearchCollect(editorSearch *search, 
+  editorSearchResults *results);
+void editorIndexToggle();
+int editorIndexIdle(long long deadline);
+
+void editorFindStart(editorSearch *search, 
+  editorSearchResults *results, int complete);
+void editorFindStop();
+int editorFindIdle(long long deadline);
+int editorFindCounter(char *buf, int size);
+unsigned char *editorFindHighlight(erow *row);
+ptrdiff_t editorReplaceAll(editorSearch *search, const char *with, 
+  ptrdiff_t *rows);
+
+void abAppend(struct abuf *ab, const char *s, size_t len);
+void abFree(struct abuf *ab);
+
+void editorGrepStart(char *query);
+void editorGrepStop();
+int editorGrepIdle(long long deadline);
+char *editorGrepResult(long *line);
+
+int editorRunScript(FILE *script, FILE *out);
+
+void editorIdle();
+
+void editorProfileStart();
+void editorProfileStop();
+void editorProfileBegin(int phase);
+void editorProfileEnd(int phase);
+void editorProfileFrame();
+int editorProfileWrite(const char *filename);
+
+#endif
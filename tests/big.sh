@@ -0,0 +1,51 @@
+#!/bin/sh
+# makes a file of more than 4 GB & one of a single line of more than
+# 2 GB, then has a batch script go to the end of each, type there, 
+# save & find what it typed. the saved file has to be the old one 
+# with the text before its last newline. it needs twice the size of 
+# the files on disk & about as much memory, saving copies the buffer.
+# usage: tests/big.sh [codible] [megabytes of the file] [megabytes 
+# of the line], 4097 & 2049 without them. TMPDIR says where they go
+codible=${1:-./codible}
+filemb=${2:-4097}
+linemb=${3:-2049}
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+failed=0
+
+# check NAME LINES COLUMN: the last line has COLUMN-1 bytes
+check() {
+  size=$(wc -c < "$work/$1")
+  cat > "$work/$1.script" <<SCRIPT
+goto $2 $3
+insert tail
+save
+goto 1
+find tail
+SCRIPT
+  printf '%s bytes written to disk\n%s:%s\n' $((size + 4)) "$2" "$3" \
+    > "$work/$1.expected"
+  if "$codible" --batch "$work/$1.script" "$work/$1" > "$work/$1.out" \
+    2>&1 && cmp -s "$work/$1.out" "$work/$1.expected" && 
+    [ "$(wc -c < "$work/$1")" -eq $((size + 4)) ] &&
+    cmp -s -n $((size - 1)) "$work/$1" "$work/$1.copy" &&
+    [ "$(tail -c 5 "$work/$1")" = tail ]; then
+    echo "ok      $1"
+  else
+    echo "FAILED  $1"; diff "$work/$1.expected" "$work/$1.out"; failed=1
+  fi
+  rm -f "$work/$1" "$work/$1.copy"
+}
+
+# lines of 1023 zeros, 1024 of them a megabyte
+yes "$(printf '%01023d' 0)" | head -c $((filemb * 1048576)) > "$work/file"
+cp "$work/file" "$work/file.copy"
+check file $((filemb * 1024)) 1024
+
+# one line of x's
+head -c $((linemb * 1048576)) /dev/zero | tr '\0' x > "$work/line"
+echo >> "$work/line"
+cp "$work/line" "$work/line.copy"
+check line 1 $((linemb * 1048576 + 1))
+
+exit $failed
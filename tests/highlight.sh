@@ -0,0 +1,48 @@
+#!/bin/sh
+# highlights a file big enough to be cut into chunks for threads, 
+# with comments running across the chunks & a long row inside one,
+# with 8 threads & without any. both have to come out the same.
+# usage: tests/highlight.sh [codible]
+codible=${1:-./codible}
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+
+awk 'function code(n) {
+    for (i=0; i<n; i++) {
+      printf "int f%d(char *s) { return s[0] == \"x\"[0] + %d; } // f\n", 
+        i, i
+    }
+  }
+  function comment(n) {
+    for (i=0; i<n; i++) {
+      printf "   comment %d with \"quotes\" & int in it\n", i
+    }
+  }
+  BEGIN {
+    code(1000)
+    print "/* a comment across many chunks"
+    comment(1500)
+    s = ""
+    for (i=0; i<7000; i++) {
+      s = s "long row "
+    }
+    print s
+    print "end */"
+    code(1000)
+    print "/* a comment up to the end of the file"
+    comment(1500)
+  }' > "$work/big.c"
+echo highlight > "$work/script"
+CODIBLE_HL_THREADS=1 "$codible" --batch "$work/script" "$work/big.c" \
+  > "$work/serial" 2>&1
+CODIBLE_HL_THREADS=8 "$codible" --batch "$work/script" "$work/big.c" \
+  > "$work/threads" 2>&1
+# the end of the file is in the comment, MLCOMMENT is 2
+if tail -n 1 "$work/serial" | grep -q ' 2222' && 
+  cmp -s "$work/serial" "$work/threads"; then
+  echo "ok      highlight threads"
+else
+  echo "FAILED  highlight threads"
+  cmp "$work/serial" "$work/threads"
+  exit 1
+fi
@@ -0,0 +1,21 @@
+#!/bin/sh
+# runs the batch scripts of tests/: NAME.script on a copy of NAME.in
+# has to print NAME.out. usage: tests/run.sh [codible]
+codible=${1:-./codible}
+dir=$(dirname "$0")
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+failed=0
+for script in "$dir"/*.script; do
+  name=$(basename "$script" .script)
+  cp "$dir/$name.in" "$work/$name.in"
+  if "$codible" --batch "$script" "$work/$name.in" > "$work/$name.out" \
+    2>&1 && cmp -s "$work/$name.out" "$dir/$name.out"; then
+    echo "ok      $name"
+  else
+    echo "FAILED  $name"
+    diff "$dir/$name.out" "$work/$name.out"
+    failed=1
+  fi
+done
+exit $failed